@@ -2,6 +2,9 @@
 #define AC_CONCEPTS_HPP
 
 #include <concepts>
+#include <cstddef>
+#include <optional>
+#include <span>
 
 namespace ac
 {
@@ -16,6 +19,70 @@ concept IsChunkAllocator = requires(T & val)
   { val.size() } -> std::same_as<size_t>;
 };
 
+// Optional bulk operations. allocate_n() fills the beginning of `out`
+// and returns how many chunks were allocated, it may be less than requested
+template<class T>
+concept IsBatchChunkAllocator = IsChunkAllocator<T> &&
+  requires(T & val,
+           std::span<typename T::chunk_type> out,
+           std::span<const typename T::chunk_type> chunks)
+{
+  { val.allocate_n(out) } -> std::same_as<size_t>;
+  val.deallocate_n(chunks);
+};
+
+// Allocators with chunk size known at compile time expose it as
+// `static_chunk_size`, so users may turn their offset math into constants
+template<class T>
+concept HasStaticChunkSize = IsChunkAllocator<T> && requires
+{
+  requires T::static_chunk_size > 0;
+};
+
+// Shared memory mapped into this process (shared_memory_allocator,
+// posix_shared_memory, memfd_shared_memory)
+template<class T>
+concept IsSharedMemorySegment = requires(const T & val)
+{
+  { val.get_base_pointer() } -> std::same_as<std::optional<void *>>;
+  { val.size() } -> std::same_as<size_t>;
+};
+
+// Use bulk operations if allocator has them, otherwise one by one
+template<IsChunkAllocator Allocator>
+size_t allocate_n(Allocator & allocator, std::span<typename Allocator::chunk_type> out)
+{
+  if constexpr (IsBatchChunkAllocator<Allocator>)
+  {
+    return allocator.allocate_n(out);
+  }
+  else
+  {
+    size_t count = 0;
+    for (; count < out.size(); ++count)
+    {
+      out[count] = allocator.allocate();
+      if (out[count].empty())
+        break;
+    }
+    return count;
+  }
+}
+
+template<IsChunkAllocator Allocator>
+void deallocate_n(Allocator & allocator, std::span<const typename Allocator::chunk_type> chunks)
+{
+  if constexpr (IsBatchChunkAllocator<Allocator>)
+  {
+    allocator.deallocate_n(chunks);
+  }
+  else
+  {
+    for (auto & it : chunks)
+      allocator.deallocate(it);
+  }
+}
+
 }
 
 #endif // AC_CONCEPTS_HPP
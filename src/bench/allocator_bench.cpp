@@ -0,0 +1,115 @@
+#include <benchmark/benchmark.h>
+#include "bench_common.hpp"
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace ac;
+using namespace ac::bench;
+
+namespace
+{
+
+enum class free_order { lifo, fifo, random };
+
+template<class Allocator>
+void alloc_free_pair(benchmark::State & state)
+{
+  const size_t chunk_size = state.range(0);
+  allocator_holder<Allocator> allocator{chunk_size, 1024};
+
+  for (auto _ : state)
+  {
+    auto chunk = allocator->allocate();
+    benchmark::DoNotOptimize(chunk.data());
+    allocator->deallocate(chunk);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+template<class Allocator, free_order Order>
+void alloc_all_free_all(benchmark::State & state)
+{
+  const size_t chunk_size = state.range(0);
+  const size_t chunks_count = state.range(1);
+  allocator_holder<Allocator> allocator{chunk_size, chunks_count};
+
+  std::vector<size_t> order(chunks_count);
+  std::iota(order.begin(), order.end(), 0);
+  if constexpr (Order == free_order::lifo)
+    std::reverse(order.begin(), order.end());
+  else if constexpr (Order == free_order::random)
+    std::shuffle(order.begin(), order.end(), std::mt19937_64{42});
+
+  std::vector<typename Allocator::chunk_type> chunks(chunks_count);
+  for (auto _ : state)
+  {
+    for (auto & it : chunks)
+      it = allocator->allocate();
+    benchmark::ClobberMemory();
+    for (auto id : order)
+      allocator->deallocate(chunks[id]);
+  }
+  state.SetItemsProcessed(state.iterations() * chunks_count);
+}
+
+// All threads share one allocator, so it's created once per benchmark run
+template<class Allocator>
+void threaded_alloc_free(benchmark::State & state)
+{
+  constexpr size_t chunk_size = 64;
+  constexpr size_t batch = 32;
+  constexpr size_t max_threads = 64;
+  static allocator_holder<Allocator> allocator{chunk_size, batch * max_threads * 4};
+
+  typename Allocator::chunk_type chunks[batch];
+  for (auto _ : state)
+  {
+    for (auto & it : chunks)
+      it = allocator->allocate();
+    benchmark::ClobberMemory();
+    for (auto & it : chunks)
+      allocator->deallocate(it);
+  }
+  state.SetItemsProcessed(state.iterations() * batch);
+}
+
+int max_bench_threads()
+{
+  return static_cast<int>(std::clamp(std::thread::hardware_concurrency(), 2u, 64u));
+}
+
+} // namespace
+
+#define AC_BENCH_ALLOCATOR(Allocator)                                                   \
+  BENCHMARK_TEMPLATE(alloc_free_pair, Allocator)                                        \
+    ->Arg(64)->Arg(512)->Arg(4096);                                                     \
+  BENCHMARK_TEMPLATE(alloc_all_free_all, Allocator, free_order::lifo)                   \
+    ->Args({64, 1024})->Args({64, 65536})->Args({4096, 1024});                          \
+  BENCHMARK_TEMPLATE(alloc_all_free_all, Allocator, free_order::fifo)                   \
+    ->Args({64, 1024})->Args({64, 65536})->Args({4096, 1024});                          \
+  BENCHMARK_TEMPLATE(alloc_all_free_all, Allocator, free_order::random)                 \
+    ->Args({64, 1024})->Args({64, 65536})->Args({4096, 1024})
+
+AC_BENCH_ALLOCATOR(static_chunk_allocator);
+AC_BENCH_ALLOCATOR(intrusive_chunk_allocator);
+AC_BENCH_ALLOCATOR(bitmap_chunk_allocator);
+AC_BENCH_ALLOCATOR(lockfree_chunk_allocator);
+AC_BENCH_ALLOCATOR(dumb_chunk_allocator);
+AC_BENCH_ALLOCATOR(sync_static_chunk_allocator);
+AC_BENCH_ALLOCATOR(cached_sync_chunk_allocator);
+AC_BENCH_ALLOCATOR(malloc_chunk_allocator);
+AC_BENCH_ALLOCATOR(pmr_unsync_chunk_allocator);
+
+BENCHMARK_TEMPLATE(threaded_alloc_free, sync_static_chunk_allocator)
+  ->ThreadRange(1, max_bench_threads())->UseRealTime();
+BENCHMARK_TEMPLATE(threaded_alloc_free, lockfree_chunk_allocator)
+  ->ThreadRange(1, max_bench_threads())->UseRealTime();
+BENCHMARK_TEMPLATE(threaded_alloc_free, cached_sync_chunk_allocator)
+  ->ThreadRange(1, max_bench_threads())->UseRealTime();
+BENCHMARK_TEMPLATE(threaded_alloc_free, malloc_chunk_allocator)
+  ->ThreadRange(1, max_bench_threads())->UseRealTime();
+BENCHMARK_TEMPLATE(threaded_alloc_free, pmr_sync_chunk_allocator)
+  ->ThreadRange(1, max_bench_threads())->UseRealTime();
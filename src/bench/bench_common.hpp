@@ -0,0 +1,115 @@
+#ifndef BENCH_COMMON_HPP
+#define BENCH_COMMON_HPP
+
+#include "static_chunk_allocator.hpp"
+#include "intrusive_chunk_allocator.hpp"
+#include "bitmap_chunk_allocator.hpp"
+#include "lockfree_chunk_allocator.hpp"
+#include "dumb_chunk_allocator.hpp"
+#include "sync_chunk_allocator.hpp"
+#include "cached_chunk_allocator.hpp"
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <type_traits>
+
+namespace ac::bench
+{
+
+// Baselines shaped as chunk allocators, so the same benchmarks run on them
+
+class malloc_chunk_allocator
+{
+public:
+  using value_type = std::byte;
+  using chunk_type = std::span<value_type>;
+
+  malloc_chunk_allocator(size_t chunk_size, size_t) :
+    _chunk_size{chunk_size}
+  {}
+
+  [[nodiscard]]
+  chunk_type allocate()
+  {
+    return {static_cast<value_type *>(::malloc(_chunk_size)), _chunk_size};
+  }
+
+  void deallocate(chunk_type chunk) { ::free(chunk.data()); }
+
+  size_t size()   const noexcept { return 0; }
+  size_t remain() const noexcept { return 0; }
+  size_t in_use() const noexcept { return 0; }
+
+private:
+  const size_t _chunk_size;
+};
+
+template<class Resource>
+class pmr_chunk_allocator
+{
+public:
+  using value_type = std::byte;
+  using chunk_type = std::span<value_type>;
+
+  pmr_chunk_allocator(size_t chunk_size, size_t) :
+    _chunk_size{chunk_size}
+  {}
+
+  [[nodiscard]]
+  chunk_type allocate()
+  {
+    return {static_cast<value_type *>(_resource.allocate(_chunk_size)), _chunk_size};
+  }
+
+  void deallocate(chunk_type chunk) { _resource.deallocate(chunk.data(), _chunk_size); }
+
+  size_t size()   const noexcept { return 0; }
+  size_t remain() const noexcept { return 0; }
+  size_t in_use() const noexcept { return 0; }
+
+private:
+  const size_t _chunk_size;
+  Resource _resource;
+};
+
+using pmr_unsync_chunk_allocator = pmr_chunk_allocator<std::pmr::unsynchronized_pool_resource>;
+using pmr_sync_chunk_allocator = pmr_chunk_allocator<std::pmr::synchronized_pool_resource>;
+
+using sync_static_chunk_allocator = sync_chunk_allocator<static_chunk_allocator>;
+using cached_sync_chunk_allocator = cached_chunk_allocator<sync_static_chunk_allocator>;
+
+inline constexpr size_t magazine_size = 64;
+
+// Owns the buffer for allocators working over caller-supplied memory
+template<class Allocator>
+class allocator_holder
+{
+public:
+  allocator_holder(size_t chunk_size, size_t chunks_count)
+  {
+    constexpr bool over_buffer = std::is_same_v<Allocator, cached_sync_chunk_allocator>
+      || std::is_constructible_v<Allocator, std::byte *, size_t, size_t>;
+    const size_t buf_len = chunk_size * chunks_count;
+    if constexpr (over_buffer)
+      _buf = std::make_unique_for_overwrite<std::byte []>(buf_len);
+
+    if constexpr (std::is_same_v<Allocator, cached_sync_chunk_allocator>)
+      _allocator = std::make_unique<Allocator>(magazine_size, _buf.get(), buf_len, chunk_size);
+    else if constexpr (over_buffer)
+      _allocator = std::make_unique<Allocator>(_buf.get(), buf_len, chunk_size);
+    else
+      _allocator = std::make_unique<Allocator>(chunk_size, chunks_count);
+  }
+
+  Allocator & operator *() noexcept { return *_allocator; }
+  Allocator * operator ->() noexcept { return _allocator.get(); }
+
+private:
+  std::unique_ptr<std::byte []> _buf;
+  std::unique_ptr<Allocator> _allocator;
+};
+
+} // namespace ac::bench
+
+#endif // BENCH_COMMON_HPP
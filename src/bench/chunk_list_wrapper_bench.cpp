@@ -0,0 +1,192 @@
+#include <benchmark/benchmark.h>
+#include "bench_common.hpp"
+#include "chunk_list_wrapper.hpp"
+#include "fixed_chunk_allocator.hpp"
+#include <memory>
+#include <random>
+#include <cstring>
+#include <vector>
+
+using namespace ac;
+using namespace ac::bench;
+
+namespace
+{
+
+constexpr size_t pool_size = 64 << 20;
+
+void write(benchmark::State & state)
+{
+  const size_t chunk_size = state.range(0);
+  const size_t len = state.range(1);
+  allocator_holder<static_chunk_allocator> allocator{chunk_size, pool_size / chunk_size};
+  chunk_list_wrapper wrapper{*allocator};
+  std::vector<std::byte> data(len);
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(wrapper.write(data.data(), data.size()));
+    wrapper.clear();
+  }
+  state.SetBytesProcessed(state.iterations() * len);
+}
+
+void read(benchmark::State & state)
+{
+  const size_t chunk_size = state.range(0);
+  const size_t len = state.range(1);
+  allocator_holder<static_chunk_allocator> allocator{chunk_size, pool_size / chunk_size};
+  chunk_list_wrapper wrapper{*allocator};
+  std::vector<std::byte> data(len);
+  (void)wrapper.write(data.data(), data.size());
+
+  for (auto _ : state)
+  {
+    std::byte * buf = nullptr;
+    size_t offset = 0;
+    while (size_t rem = wrapper.read(offset, buf, len - offset))
+    {
+      benchmark::DoNotOptimize(buf);
+      offset += rem;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * len);
+}
+
+void read_copy(benchmark::State & state)
+{
+  const size_t chunk_size = state.range(0);
+  const size_t len = state.range(1);
+  allocator_holder<static_chunk_allocator> allocator{chunk_size, pool_size / chunk_size};
+  chunk_list_wrapper wrapper{*allocator};
+  std::vector<std::byte> data(len);
+  (void)wrapper.write(data.data(), data.size());
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(wrapper.read_copy(0, data.data(), data.size()));
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * len);
+}
+
+void wrapper_args(benchmark::internal::Benchmark * bench)
+{
+  for (long chunk_size : {512, 4096})
+    for (long len : {4 << 10, 1 << 20})
+      bench->Args({chunk_size, len});
+}
+
+} // namespace
+
+BENCHMARK(write)->Apply(wrapper_args);
+BENCHMARK(read)->Apply(wrapper_args);
+BENCHMARK(read_copy)->Apply(wrapper_args);
+
+namespace
+{
+
+// Needle is placed at the very end, so the whole data is scanned
+void find_byte(benchmark::State & state)
+{
+  const size_t chunk_size = state.range(0);
+  const size_t len = state.range(1);
+  allocator_holder<static_chunk_allocator> allocator{chunk_size, pool_size / chunk_size};
+  chunk_list_wrapper wrapper{*allocator};
+  std::vector<std::byte> data(len);
+  data.back() = std::byte{'\n'};
+  (void)wrapper.write(data.data(), data.size());
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(wrapper.find(std::byte{'\n'}));
+  state.SetBytesProcessed(state.iterations() * len);
+}
+
+void find_byte_memchr(benchmark::State & state)
+{
+  const size_t len = state.range(1);
+  std::vector<std::byte> data(len);
+  data.back() = std::byte{'\n'};
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(::memchr(data.data(), '\n', data.size()));
+  state.SetBytesProcessed(state.iterations() * len);
+}
+
+void find_crlf(benchmark::State & state)
+{
+  const size_t chunk_size = state.range(0);
+  const size_t len = state.range(1);
+  allocator_holder<static_chunk_allocator> allocator{chunk_size, pool_size / chunk_size};
+  chunk_list_wrapper wrapper{*allocator};
+  // Lone '\r' every 64 bytes makes the search check candidates
+  std::vector<std::byte> data(len);
+  for (size_t i = 0; i < len; i += 64)
+    data[i] = std::byte{'\r'};
+  data[len - 2] = std::byte{'\r'};
+  data[len - 1] = std::byte{'\n'};
+  (void)wrapper.write(data.data(), data.size());
+
+  const std::byte crlf[] = {std::byte{'\r'}, std::byte{'\n'}};
+  for (auto _ : state)
+    benchmark::DoNotOptimize(wrapper.find(crlf));
+  state.SetBytesProcessed(state.iterations() * len);
+}
+
+} // namespace
+
+BENCHMARK(find_byte)->Apply(wrapper_args);
+BENCHMARK(find_byte_memchr)->Apply(wrapper_args);
+BENCHMARK(find_crlf)->Apply(wrapper_args);
+
+namespace
+{
+
+constexpr size_t random_access_len = 1 << 20;
+
+// Every access looks up the chunk, so the offset math dominates
+template<class Wrapper>
+void random_access(benchmark::State & state, Wrapper & wrapper)
+{
+  std::vector<std::byte> data(random_access_len);
+  (void)wrapper.write(data.data(), data.size());
+
+  std::vector<size_t> offsets(4096);
+  std::mt19937_64 rng{42};
+  for (auto & it : offsets)
+    it = rng() % random_access_len;
+
+  for (auto _ : state)
+  {
+    for (auto it : offsets)
+    {
+      std::byte * buf = nullptr;
+      benchmark::DoNotOptimize(wrapper.read(it, buf, 1));
+      benchmark::DoNotOptimize(buf);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * offsets.size());
+}
+
+template<size_t ChunkSize>
+void random_access_static(benchmark::State & state)
+{
+  allocator_holder<static_chunk_allocator> allocator{ChunkSize, random_access_len / ChunkSize};
+  chunk_list_wrapper wrapper{*allocator};
+  random_access(state, wrapper);
+}
+
+template<size_t ChunkSize>
+void random_access_fixed(benchmark::State & state)
+{
+  auto allocator = std::make_unique<fixed_chunk_allocator<ChunkSize, random_access_len / ChunkSize>>();
+  chunk_list_wrapper wrapper{*allocator};
+  random_access(state, wrapper);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(random_access_static, 512);
+BENCHMARK_TEMPLATE(random_access_fixed, 512);
+BENCHMARK_TEMPLATE(random_access_static, 4096);
+BENCHMARK_TEMPLATE(random_access_fixed, 4096);
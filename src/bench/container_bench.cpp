@@ -0,0 +1,186 @@
+#include <benchmark/benchmark.h>
+#include "bench_common.hpp"
+#include "chunk_memory_resource.hpp"
+#include "object_pool.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace ac;
+using namespace ac::bench;
+
+namespace
+{
+
+// Nodes of std::list<int> and std::map<int, int> fit it
+constexpr size_t node_size = 64;
+
+std::vector<int> shuffled_keys(size_t count)
+{
+  std::vector<int> ret(count);
+  std::iota(ret.begin(), ret.end(), 0);
+  std::shuffle(ret.begin(), ret.end(), std::mt19937_64{42});
+  return ret;
+}
+
+// Container is created by `make` once, so only node allocations are measured
+template<class MakeList>
+void list_push_erase(benchmark::State & state, MakeList make)
+{
+  const size_t count = state.range(0);
+  auto list = make();
+
+  for (auto _ : state)
+  {
+    for (size_t i = 0; i < count; ++i)
+      list.push_back(static_cast<int>(i));
+    benchmark::ClobberMemory();
+    list.clear();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+template<class MakeMap>
+void map_insert_erase(benchmark::State & state, MakeMap make)
+{
+  const auto keys = shuffled_keys(state.range(0));
+  auto map = make();
+
+  for (auto _ : state)
+  {
+    for (int key : keys)
+      map.emplace(key, key);
+    benchmark::ClobberMemory();
+    for (int key : keys)
+      map.erase(key);
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template<class Allocator>
+class pool_holder
+{
+public:
+  explicit pool_holder(size_t chunks_count) :
+    _allocator{node_size, chunks_count},
+    _resource{*_allocator, node_size}
+  {}
+
+  chunk_memory_resource<Allocator> & resource() noexcept { return _resource; }
+
+private:
+  allocator_holder<Allocator> _allocator;
+  chunk_memory_resource<Allocator> _resource;
+};
+
+void list_std_allocator(benchmark::State & state)
+{
+  list_push_erase(state, [] { return std::list<int>{}; });
+}
+
+template<class Allocator>
+void list_chunk_allocator(benchmark::State & state)
+{
+  pool_holder<Allocator> pool{static_cast<size_t>(state.range(0))};
+  list_push_erase(state, [&]
+  {
+    return std::list<int, chunk_stl_allocator<int, Allocator>>{pool.resource()};
+  });
+}
+
+void list_pmr_pool(benchmark::State & state)
+{
+  std::pmr::unsynchronized_pool_resource resource;
+  list_push_erase(state, [&] { return std::pmr::list<int>{&resource}; });
+}
+
+template<class Allocator>
+void list_pmr_chunk_resource(benchmark::State & state)
+{
+  pool_holder<Allocator> pool{static_cast<size_t>(state.range(0))};
+  list_push_erase(state, [&] { return std::pmr::list<int>{&pool.resource()}; });
+}
+
+void map_std_allocator(benchmark::State & state)
+{
+  map_insert_erase(state, [] { return std::map<int, int>{}; });
+}
+
+template<class Allocator>
+void map_chunk_allocator(benchmark::State & state)
+{
+  using value_type = std::pair<const int, int>;
+  pool_holder<Allocator> pool{static_cast<size_t>(state.range(0))};
+  map_insert_erase(state, [&]
+  {
+    return std::map<int, int, std::less<int>, chunk_stl_allocator<value_type, Allocator>>{pool.resource()};
+  });
+}
+
+void map_pmr_pool(benchmark::State & state)
+{
+  std::pmr::unsynchronized_pool_resource resource;
+  map_insert_erase(state, [&] { return std::pmr::map<int, int>{&resource}; });
+}
+
+// Stands for a session object
+struct session
+{
+  uint64_t id;
+  uint64_t fields[7];
+};
+
+void object_pool_create_destroy(benchmark::State & state)
+{
+  const size_t count = state.range(0);
+  constexpr size_t chunk_size = 4096;
+  allocator_holder<intrusive_chunk_allocator> allocator{chunk_size, count * sizeof(session) / chunk_size + 1};
+  object_pool<session, intrusive_chunk_allocator> pool{*allocator};
+
+  std::vector<session *> sessions(count);
+  for (auto _ : state)
+  {
+    for (size_t i = 0; i < count; ++i)
+      sessions[i] = pool.create(session{i, {}});
+    benchmark::ClobberMemory();
+    for (auto * it : sessions)
+      pool.destroy(it);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+void make_unique_create_destroy(benchmark::State & state)
+{
+  const size_t count = state.range(0);
+
+  std::vector<std::unique_ptr<session>> sessions(count);
+  for (auto _ : state)
+  {
+    for (size_t i = 0; i < count; ++i)
+      sessions[i] = std::make_unique<session>(session{i, {}});
+    benchmark::ClobberMemory();
+    for (auto & it : sessions)
+      it.reset();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+} // namespace
+
+BENCHMARK(list_std_allocator)->Arg(1024)->Arg(64 << 10);
+BENCHMARK_TEMPLATE(list_chunk_allocator, intrusive_chunk_allocator)->Arg(1024)->Arg(64 << 10);
+BENCHMARK_TEMPLATE(list_chunk_allocator, static_chunk_allocator)->Arg(1024)->Arg(64 << 10);
+BENCHMARK(list_pmr_pool)->Arg(1024)->Arg(64 << 10);
+BENCHMARK_TEMPLATE(list_pmr_chunk_resource, intrusive_chunk_allocator)->Arg(1024)->Arg(64 << 10);
+
+BENCHMARK(map_std_allocator)->Arg(1024)->Arg(64 << 10);
+BENCHMARK_TEMPLATE(map_chunk_allocator, intrusive_chunk_allocator)->Arg(1024)->Arg(64 << 10);
+BENCHMARK(map_pmr_pool)->Arg(1024)->Arg(64 << 10);
+
+BENCHMARK(object_pool_create_destroy)->Arg(1024)->Arg(64 << 10);
+BENCHMARK(make_unique_create_destroy)->Arg(1024)->Arg(64 << 10);
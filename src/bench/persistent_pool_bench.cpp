@@ -0,0 +1,121 @@
+#include <benchmark/benchmark.h>
+#include "persistent_chunk_pool.hpp"
+#include <new>
+#include <vector>
+
+using namespace ac;
+
+namespace
+{
+
+constexpr size_t segment_size = 64 << 20;
+constexpr size_t chunk_size = 4096;
+constexpr size_t lists_count = 64;
+
+// Zero-filled and aligned like a new shared memory segment
+class segment_holder
+{
+public:
+  explicit segment_holder(size_t size) :
+    _buf{new (std::align_val_t{64}) std::byte[size]{}},
+    _size{size}
+  {}
+
+  ~segment_holder()
+  {
+    ::operator delete[](_buf, std::align_val_t{64});
+  }
+
+  std::byte * data() const noexcept { return _buf; }
+  size_t size() const noexcept { return _size; }
+
+private:
+  std::byte * _buf;
+  size_t _size;
+};
+
+// Fills the pool with lists of `len` bytes each and stores them
+void fill_lists(segment_holder & segment, size_t len)
+{
+  persistent_chunk_pool pool{segment.data(), segment.size(), chunk_size, lists_count};
+  std::vector<std::byte> data(len, std::byte{0x5a});
+  for (size_t i = 0; i < lists_count; ++i)
+  {
+    persistent_chunk_list list{pool};
+    (void)list.write(data.data(), data.size());
+    (void)pool.store(i, list);
+  }
+}
+
+// Restart of a process that closed the pool: attach, take the lists back
+// and park them again
+void persistent_reattach(benchmark::State & state)
+{
+  segment_holder segment{segment_size};
+  fill_lists(segment, state.range(0));
+
+  for (auto _ : state)
+  {
+    persistent_chunk_pool pool{segment.data(), segment.size(), chunk_size, lists_count};
+    for (size_t i = 0; i < lists_count; ++i)
+    {
+      persistent_chunk_list list{pool};
+      (void)pool.load(i, list);
+      benchmark::DoNotOptimize(list.size());
+      (void)pool.store(i, list);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * lists_count * state.range(0));
+}
+
+// Same after a crash, the pool is recovered first
+void persistent_recover(benchmark::State & state)
+{
+  segment_holder segment{segment_size};
+  fill_lists(segment, state.range(0));
+  auto * header = reinterpret_cast<detail::persistent_pool_header *>(segment.data());
+
+  for (auto _ : state)
+  {
+    header->state.store(detail::persistent_pool_header::open);
+    persistent_chunk_pool pool{segment.data(), segment.size(), chunk_size, lists_count};
+    for (size_t i = 0; i < lists_count; ++i)
+    {
+      persistent_chunk_list list{pool};
+      (void)pool.load(i, list);
+      benchmark::DoNotOptimize(list.size());
+      (void)pool.store(i, list);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * lists_count * state.range(0));
+}
+
+// Cold start: the data is written to a fresh pool again
+void cold_rebuild(benchmark::State & state)
+{
+  segment_holder segment{segment_size};
+  std::vector<std::byte> data(state.range(0), std::byte{0x5a});
+
+  for (auto _ : state)
+  {
+    persistent_chunk_pool pool{segment.data(), segment.size(), chunk_size, lists_count};
+    std::vector<persistent_chunk_list> lists;
+    lists.reserve(lists_count);
+    for (size_t i = 0; i < lists_count; ++i)
+    {
+      lists.emplace_back(pool);
+      (void)lists.back().write(data.data(), data.size());
+    }
+    benchmark::DoNotOptimize(segment.data());
+    lists.clear();
+    // Broken magic makes the next pool format the segment
+    segment.data()[0] = std::byte{0};
+  }
+  state.SetBytesProcessed(state.iterations() * lists_count * state.range(0));
+}
+
+} // namespace
+
+BENCHMARK(persistent_reattach)->Arg(256 << 10);
+BENCHMARK(persistent_recover)->Arg(256 << 10);
+BENCHMARK(cold_rebuild)->Arg(256 << 10);
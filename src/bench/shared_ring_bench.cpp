@@ -0,0 +1,110 @@
+#include <benchmark/benchmark.h>
+#include "shared_ring.hpp"
+#include <atomic>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+using namespace ac;
+
+namespace
+{
+
+// Zero-filled and aligned like a new shared memory segment
+class segment_holder
+{
+public:
+  explicit segment_holder(size_t size) :
+    _buf{new (std::align_val_t{64}) std::byte[size]{}},
+    _size{size}
+  {}
+
+  ~segment_holder()
+  {
+    ::operator delete[](_buf, std::align_val_t{64});
+  }
+
+  std::byte * data() const noexcept { return _buf; }
+  size_t size() const noexcept { return _size; }
+
+private:
+  std::byte * _buf;
+  size_t _size;
+};
+
+// Round trip of a message through two rings, the other side is a thread
+// here, but the same code runs between processes
+void spsc_round_trip(benchmark::State & state)
+{
+  const size_t len = state.range(0);
+  segment_holder ping_segment{1 << 16};
+  segment_holder pong_segment{1 << 16};
+  std::atomic<bool> done{false};
+
+  std::thread echo([&]
+  {
+    spsc_ring ping{ping_segment.data(), ping_segment.size()};
+    spsc_ring pong{pong_segment.data(), pong_segment.size()};
+    while (done.load(std::memory_order_relaxed) == false)
+    {
+      size_t count = ping.consume([&](auto message)
+      {
+        while (pong.try_push(message) == false)
+          std::this_thread::yield();
+      });
+      if (count == 0)
+        std::this_thread::yield();
+    }
+  });
+
+  spsc_ring ping{ping_segment.data(), ping_segment.size()};
+  spsc_ring pong{pong_segment.data(), pong_segment.size()};
+  std::vector<std::byte> message(len);
+  for (auto _ : state)
+  {
+    while (ping.try_push(message) == false)
+      std::this_thread::yield();
+    while (pong.consume([](auto) {}, 1) == 0)
+      std::this_thread::yield();
+  }
+  done.store(true, std::memory_order_relaxed);
+  echo.join();
+  state.SetItemsProcessed(state.iterations());
+}
+
+template<class Ring>
+void ring_throughput(benchmark::State & state)
+{
+  const size_t len = state.range(0);
+  segment_holder segment{1 << 20};
+  std::atomic<bool> done{false};
+
+  std::thread consumer([&]
+  {
+    Ring ring{segment.data(), segment.size()};
+    while (done.load(std::memory_order_relaxed) == false)
+    {
+      if (ring.consume([](auto message) { benchmark::DoNotOptimize(message.data()); }) == 0)
+        std::this_thread::yield();
+    }
+  });
+
+  Ring ring{segment.data(), segment.size()};
+  std::vector<std::byte> message(len);
+  for (auto _ : state)
+  {
+    while (ring.try_push(message) == false)
+      std::this_thread::yield();
+  }
+  done.store(true, std::memory_order_relaxed);
+  consumer.join();
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * len);
+}
+
+} // namespace
+
+BENCHMARK(spsc_round_trip)->Arg(64)->Arg(1024)->UseRealTime();
+BENCHMARK_TEMPLATE(ring_throughput, spsc_ring)->Arg(64)->Arg(1024)->UseRealTime();
+BENCHMARK_TEMPLATE(ring_throughput, mpsc_ring)->Arg(64)->Arg(1024)->UseRealTime();
@@ -0,0 +1,141 @@
+#include <benchmark/benchmark.h>
+#include "size_class_allocator.hpp"
+#include "buddy_allocator.hpp"
+#include "monotonic_arena.hpp"
+#include "intrusive_chunk_allocator.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace ac;
+
+namespace
+{
+
+constexpr size_t batch = 256;
+
+// Log-uniform sizes in [16, max_len], like a mix of small and big messages
+std::vector<size_t> random_sizes(size_t max_len)
+{
+  std::mt19937_64 rng{42};
+  std::uniform_real_distribution<double> dist{4.0, std::log2(static_cast<double>(max_len))};
+  std::vector<size_t> ret(batch);
+  for (auto & it : ret)
+    it = static_cast<size_t>(std::exp2(dist(rng)));
+  return ret;
+}
+
+std::vector<size_t> random_order()
+{
+  std::vector<size_t> ret(batch);
+  std::iota(ret.begin(), ret.end(), 0);
+  std::shuffle(ret.begin(), ret.end(), std::mt19937_64{7});
+  return ret;
+}
+
+void size_class_alloc_free(benchmark::State & state)
+{
+  const auto sizes = random_sizes(state.range(0));
+  const auto order = random_order();
+  auto classes = geometric_size_classes(64, 64 << 10, batch * (64 << 10) / 4);
+  const size_t buf_len = size_class_allocator<>::required_size(classes);
+  auto buf = std::make_unique_for_overwrite<std::byte []>(buf_len);
+  size_class_allocator allocator{buf.get(), buf_len, classes};
+
+  std::vector<std::byte *> ptrs(batch);
+  for (auto _ : state)
+  {
+    for (size_t i = 0; i < batch; ++i)
+      ptrs[i] = allocator.allocate(sizes[i]).data();
+    benchmark::ClobberMemory();
+    for (auto i : order)
+      allocator.deallocate(ptrs[i]);
+  }
+  state.SetItemsProcessed(state.iterations() * batch);
+}
+
+void buddy_alloc_free(benchmark::State & state)
+{
+  const auto sizes = random_sizes(state.range(0));
+  const auto order = random_order();
+  // Rounding up at most doubles the batch
+  const size_t buf_len = std::bit_ceil(2 * batch * static_cast<size_t>(state.range(0)));
+  auto buf = std::make_unique_for_overwrite<std::byte []>(buf_len);
+  buddy_allocator allocator{buf.get(), buf_len, 64};
+
+  std::vector<buddy_allocator::chunk_type> blocks(batch);
+  for (auto _ : state)
+  {
+    for (size_t i = 0; i < batch; ++i)
+      blocks[i] = allocator.allocate(sizes[i]);
+    benchmark::ClobberMemory();
+    for (auto i : order)
+      allocator.deallocate(blocks[i]);
+  }
+  state.SetItemsProcessed(state.iterations() * batch);
+}
+
+void malloc_alloc_free(benchmark::State & state)
+{
+  const auto sizes = random_sizes(state.range(0));
+  const auto order = random_order();
+
+  std::vector<void *> ptrs(batch);
+  for (auto _ : state)
+  {
+    for (size_t i = 0; i < batch; ++i)
+      ptrs[i] = ::malloc(sizes[i]);
+    benchmark::ClobberMemory();
+    for (auto i : order)
+      ::free(ptrs[i]);
+  }
+  state.SetItemsProcessed(state.iterations() * batch);
+}
+
+// Scratch memory of one request: many small allocations freed together
+void arena_scratch(benchmark::State & state)
+{
+  const auto sizes = random_sizes(state.range(0));
+  constexpr size_t chunk_size = 64 << 10;
+  const size_t buf_len = chunk_size * 64;
+  auto buf = std::make_unique_for_overwrite<std::byte []>(buf_len);
+  intrusive_chunk_allocator allocator{buf.get(), buf_len, chunk_size};
+  monotonic_arena arena{allocator};
+
+  for (auto _ : state)
+  {
+    for (auto len : sizes)
+      benchmark::DoNotOptimize(arena.allocate(len, 8));
+    arena.reset();
+  }
+  state.SetItemsProcessed(state.iterations() * batch);
+}
+
+void malloc_scratch(benchmark::State & state)
+{
+  const auto sizes = random_sizes(state.range(0));
+
+  std::vector<void *> ptrs(batch);
+  for (auto _ : state)
+  {
+    for (size_t i = 0; i < batch; ++i)
+      ptrs[i] = ::malloc(sizes[i]);
+    benchmark::ClobberMemory();
+    for (auto * it : ptrs)
+      ::free(it);
+  }
+  state.SetItemsProcessed(state.iterations() * batch);
+}
+
+} // namespace
+
+BENCHMARK(size_class_alloc_free)->Arg(1024)->Arg(64 << 10);
+BENCHMARK(buddy_alloc_free)->Arg(1024)->Arg(64 << 10);
+BENCHMARK(malloc_alloc_free)->Arg(1024)->Arg(64 << 10);
+BENCHMARK(arena_scratch)->Arg(64)->Arg(1024);
+BENCHMARK(malloc_scratch)->Arg(64)->Arg(1024);
@@ -0,0 +1,242 @@
+#ifndef BITMAP_CHUNK_ALLOCATOR_HPP
+#define BITMAP_CHUNK_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <cassert>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace ac
+{
+
+namespace detail
+{
+
+// Returns index of the first non-zero word starting from `from`,
+// or `count` if there is none
+[[nodiscard]]
+inline size_t find_nonzero_word(const uint64_t * words, size_t count, size_t from) noexcept
+{
+  size_t i = from;
+#ifdef __AVX2__
+  for (; i + 4 <= count; i += 4)
+  {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(words + i));
+    if (_mm256_testz_si256(v, v) == 0)
+      break;
+  }
+#endif
+  for (; i < count; ++i)
+  {
+    if (words[i] != 0)
+      return i;
+  }
+  return count;
+}
+
+} // namespace detail
+
+// Works over caller-supplied buffer like static_chunk_allocator.
+// Occupancy is tracked with one bit per chunk (set bit means free chunk)
+// plus a summary level with one bit per leaf word that has a free chunk.
+// The lowest free address is always handed out first, so the working set
+// stays dense. allocate(count) returns a run of adjacent chunks as a single
+// span, which may be returned with a single deallocate() call.
+
+class bitmap_chunk_allocator
+{
+public:
+  using value_type = std::byte;
+  using chunk_type = std::span<value_type>;
+
+public:
+  bitmap_chunk_allocator(value_type * buf, size_t buf_len, size_t chunk_size) :
+    _buf{buf, buf_len}, _chunk_size{chunk_size},
+    _chunks_count{_buf.size_bytes() / _chunk_size},
+    _remain{0},
+    _leaf_words(words_for(_chunks_count)),
+    _summary_words(words_for(_leaf_words.size()))
+  {
+    assert((buf_len % chunk_size) == 0 && "There MUSTN'T be the remainder");
+    set_range(0, _chunks_count);
+  }
+
+  [[nodiscard]]
+  chunk_type allocate()
+  {
+    size_t summary_id = detail::find_nonzero_word(_summary_words.data(),
+                                                  _summary_words.size(), 0);
+    if (summary_id == _summary_words.size())
+      return {};
+
+    size_t leaf_id = summary_id * bits_per_word
+      + std::countr_zero(_summary_words[summary_id]);
+    size_t chunk_id = leaf_id * bits_per_word
+      + std::countr_zero(_leaf_words[leaf_id]);
+
+    clear_range(chunk_id, 1);
+    return _buf.subspan(_chunk_size * chunk_id, _chunk_size);
+  }
+
+  // Allocates `count` physically adjacent chunks at the lowest possible address
+  [[nodiscard]]
+  chunk_type allocate(size_t count)
+  {
+    if (count == 0 || count > _remain)
+      return {};
+    if (count == 1)
+      return allocate();
+
+    size_t chunk_id = find_run(count);
+    if (chunk_id == npos)
+      return {};
+
+    clear_range(chunk_id, count);
+    return _buf.subspan(_chunk_size * chunk_id, _chunk_size * count);
+  }
+
+  void deallocate(chunk_type chunk)
+  {
+    if (chunk.empty() || chunk.size() % _chunk_size != 0)
+      return;
+    size_t chunk_place = chunk.data() - _buf.data();
+    if (chunk_place % _chunk_size != 0)
+      return;
+    size_t chunk_id = chunk_place / _chunk_size;
+    size_t count = chunk.size() / _chunk_size;
+    if (chunk_id >= _chunks_count || count > _chunks_count - chunk_id)
+      return;
+
+    set_range(chunk_id, count);
+  }
+
+  size_t size()   const noexcept { return _chunks_count; }
+  size_t remain() const noexcept { return _remain; }
+  size_t in_use() const noexcept { return size() - remain(); }
+
+private:
+  static constexpr size_t bits_per_word = 64;
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  chunk_type _buf;
+  const size_t _chunk_size;
+  const size_t _chunks_count;
+  size_t _remain;
+  std::vector<uint64_t> _leaf_words;
+  std::vector<uint64_t> _summary_words;
+
+  static constexpr size_t words_for(size_t bits) noexcept
+  {
+    return (bits + bits_per_word - 1) / bits_per_word;
+  }
+
+  // Mask of `count` bits starting from `first` within one word
+  static constexpr uint64_t word_mask(size_t first, size_t count) noexcept
+  {
+    uint64_t mask = count == bits_per_word ? ~uint64_t{0} : (uint64_t{1} << count) - 1;
+    return mask << first;
+  }
+
+  void update_summary(size_t leaf_id) noexcept
+  {
+    uint64_t bit = uint64_t{1} << (leaf_id % bits_per_word);
+    if (_leaf_words[leaf_id] != 0)
+      _summary_words[leaf_id / bits_per_word] |= bit;
+    else
+      _summary_words[leaf_id / bits_per_word] &= ~bit;
+  }
+
+  // Marks chunks as free, already free chunks are ignored
+  void set_range(size_t chunk_id, size_t count) noexcept
+  {
+    while (count > 0)
+    {
+      size_t leaf_id = chunk_id / bits_per_word;
+      size_t first = chunk_id % bits_per_word;
+      size_t n = std::min(count, bits_per_word - first);
+      uint64_t mask = word_mask(first, n);
+
+      _remain += std::popcount(mask & ~_leaf_words[leaf_id]);
+      _leaf_words[leaf_id] |= mask;
+      update_summary(leaf_id);
+
+      chunk_id += n;
+      count -= n;
+    }
+  }
+
+  // Marks chunks as busy, caller MUST ensure all of them are free
+  void clear_range(size_t chunk_id, size_t count) noexcept
+  {
+    _remain -= count;
+    while (count > 0)
+    {
+      size_t leaf_id = chunk_id / bits_per_word;
+      size_t first = chunk_id % bits_per_word;
+      size_t n = std::min(count, bits_per_word - first);
+
+      _leaf_words[leaf_id] &= ~word_mask(first, n);
+      update_summary(leaf_id);
+
+      chunk_id += n;
+      count -= n;
+    }
+  }
+
+  // Returns id of the first chunk of the lowest run of `count` free chunks
+  size_t find_run(size_t count) const noexcept
+  {
+    size_t run_start = 0;
+    size_t run_len = 0;
+    size_t leaf_id = 0;
+
+    while (leaf_id < _leaf_words.size())
+    {
+      if (run_len == 0)
+      {
+        // Words without free chunks can't start a run
+        leaf_id = detail::find_nonzero_word(_leaf_words.data(),
+                                            _leaf_words.size(), leaf_id);
+        if (leaf_id == _leaf_words.size())
+          break;
+      }
+
+      const uint64_t word = _leaf_words[leaf_id];
+      size_t pos = 0;
+      while (pos < bits_per_word)
+      {
+        uint64_t rest = word >> pos;
+        if (run_len == 0)
+        {
+          if (rest == 0)
+            break;
+          pos += std::countr_zero(rest);
+          run_start = leaf_id * bits_per_word + pos;
+          rest = word >> pos;
+        }
+
+        // Bits shifted in are zeroes, so it never counts past the word
+        size_t ones = std::countr_one(rest);
+        run_len += ones;
+        pos += ones;
+        if (run_len >= count)
+          return run_start;
+        if (pos < bits_per_word)
+          run_len = 0;
+      }
+      ++leaf_id;
+    }
+    return npos;
+  }
+};
+
+} // namespace ac
+
+#endif // BITMAP_CHUNK_ALLOCATOR_HPP
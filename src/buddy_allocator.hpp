@@ -0,0 +1,258 @@
+#ifndef BUDDY_ALLOCATOR_HPP
+#define BUDDY_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <vector>
+#include <cassert>
+
+namespace ac
+{
+
+// Works over caller-supplied buffer like static_chunk_allocator, but serves
+// contiguous blocks of `min_block << order` bytes. A request is rounded up
+// to such a block, a bigger free block is split in halves to get it, and a
+// freed block is merged with its free buddy back, so free memory doesn't
+// crumble into small pieces.
+//
+// Every order has a free list linked through the bodies of free blocks and
+// two bitmaps: blocks that are free and blocks that are handed out at that
+// order. Buddy state and validity of a freed block are single bit tests,
+// allocate() and deallocate() take O(log n) steps (one per order).
+// Buffer length doesn't have to be a power of two, its tail is split
+// into smaller top-level blocks. size(), remain() and in_use() are in bytes.
+
+class buddy_allocator
+{
+public:
+  using value_type = std::byte;
+  using chunk_type = std::span<value_type>;
+
+public:
+  buddy_allocator(value_type * buf, size_t buf_len, size_t min_block) :
+    _buf{buf, buf_len}, _min_block{min_block},
+    _blocks_count{_buf.size_bytes() / _min_block},
+    _max_order{_blocks_count == 0 ? 0 : static_cast<size_t>(std::bit_width(_blocks_count) - 1)},
+    _levels(_max_order + 1)
+  {
+    assert((buf_len % min_block) == 0 && "There MUSTN'T be the remainder");
+    assert(min_block >= 2 * sizeof(block_id_type) && "Block MUST fit the free list links");
+    assert(_blocks_count < npos && "Too many blocks to index");
+
+    for (size_t order = 0; order <= _max_order; ++order)
+    {
+      auto & level = _levels[order];
+      level.free.resize(words_for(_blocks_count >> order));
+      level.allocated.resize(level.free.size());
+    }
+
+    // The biggest aligned blocks that fit
+    for (size_t block = 0; block < _blocks_count;)
+    {
+      size_t order = std::min<size_t>(std::countr_zero(block | (size_t{1} << _max_order)), _max_order);
+      while (block + (size_t{1} << order) > _blocks_count)
+        --order;
+      push_free(order, block >> order);
+      block += size_t{1} << order;
+    }
+  }
+
+  // Returns block of `min_block << order` bytes, where it's
+  // the smallest such block that fits `len` bytes
+  [[nodiscard]]
+  chunk_type allocate(size_t len)
+  {
+    if (len == 0)
+      return {};
+    const size_t order = order_for(len);
+    if (order > _max_order)
+      return {};
+
+    size_t from = order;
+    while (from <= _max_order && _levels[from].head == npos)
+      ++from;
+    if (from > _max_order)
+      return {};
+
+    size_t index = _levels[from].head;
+    pop_free(from, index);
+    // The upper halves stay free
+    for (; from > order; --from)
+    {
+      index *= 2;
+      push_free(from - 1, index + 1);
+    }
+
+    set_bit(_levels[order].allocated, index);
+    _in_use += block_size(order);
+    return _buf.subspan(index * block_size(order), block_size(order));
+  }
+
+  // Block MUST be passed as returned by allocate(), other blocks are ignored
+  void deallocate(chunk_type block)
+  {
+    if (block.empty() || block.size() % _min_block != 0)
+      return;
+    size_t units = block.size() / _min_block;
+    if (std::has_single_bit(units) == false)
+      return;
+    size_t order = std::countr_zero(units);
+    if (order > _max_order)
+      return;
+
+    size_t place = block.data() - _buf.data();
+    if (place % block.size() != 0 || place / block.size() >= (_blocks_count >> order))
+      return;
+    size_t index = place / block.size();
+    if (test_bit(_levels[order].allocated, index) == false)
+      return;
+
+    reset_bit(_levels[order].allocated, index);
+    _in_use -= block.size();
+
+    // Merge with free buddies while the parent block fits the buffer
+    while (order < _max_order && (index | 1) < (_blocks_count >> order)
+           && test_bit(_levels[order].free, index ^ 1))
+    {
+      pop_free(order, index ^ 1);
+      index /= 2;
+      ++order;
+    }
+    push_free(order, index);
+  }
+
+  size_t size()   const noexcept { return _blocks_count * _min_block; }
+  size_t remain() const noexcept { return size() - in_use(); }
+  size_t in_use() const noexcept { return _in_use; }
+
+  size_t min_block() const noexcept { return _min_block; }
+  size_t max_block() const noexcept { return block_size(_max_order); }
+
+  // The biggest block that may be allocated now, 0 if there is none
+  size_t largest_free() const noexcept
+  {
+    for (size_t order = _max_order + 1; order > 0; --order)
+    {
+      if (_levels[order - 1].head != npos)
+        return block_size(order - 1);
+    }
+    return 0;
+  }
+
+private:
+  using block_id_type = uint32_t;
+  static constexpr block_id_type npos = std::numeric_limits<block_id_type>::max();
+  static constexpr size_t bits_per_word = 64;
+
+  struct level
+  {
+    std::vector<uint64_t> free;
+    std::vector<uint64_t> allocated;
+    block_id_type head{npos};
+  };
+
+  // Free list links, stored at the beginning of the free block
+  struct links
+  {
+    block_id_type prev;
+    block_id_type next;
+  };
+
+  chunk_type _buf;
+  const size_t _min_block;
+  const size_t _blocks_count;
+  const size_t _max_order;
+  std::vector<level> _levels;
+  size_t _in_use{0};
+
+  static constexpr size_t words_for(size_t bits) noexcept
+  {
+    return (bits + bits_per_word - 1) / bits_per_word;
+  }
+
+  static bool test_bit(const std::vector<uint64_t> & words, size_t bit) noexcept
+  {
+    return (words[bit / bits_per_word] >> (bit % bits_per_word)) & 1;
+  }
+
+  static void set_bit(std::vector<uint64_t> & words, size_t bit) noexcept
+  {
+    words[bit / bits_per_word] |= uint64_t{1} << (bit % bits_per_word);
+  }
+
+  static void reset_bit(std::vector<uint64_t> & words, size_t bit) noexcept
+  {
+    words[bit / bits_per_word] &= ~(uint64_t{1} << (bit % bits_per_word));
+  }
+
+  size_t block_size(size_t order) const noexcept
+  {
+    return _min_block << order;
+  }
+
+  size_t order_for(size_t len) const noexcept
+  {
+    size_t units = (len + _min_block - 1) / _min_block;
+    return std::bit_width(units - 1);
+  }
+
+  // Blocks aren't required to be aligned, so links are copied bytewise
+  links load_links(size_t order, size_t index) const noexcept
+  {
+    links ret;
+    ::memcpy(&ret, _buf.data() + index * block_size(order), sizeof(ret));
+    return ret;
+  }
+
+  void store_links(size_t order, size_t index, links val) noexcept
+  {
+    ::memcpy(_buf.data() + index * block_size(order), &val, sizeof(val));
+  }
+
+  void push_free(size_t order, size_t index) noexcept
+  {
+    auto & level = _levels[order];
+    if (level.head != npos)
+    {
+      auto head = load_links(order, level.head);
+      head.prev = static_cast<block_id_type>(index);
+      store_links(order, level.head, head);
+    }
+    store_links(order, index, links{npos, level.head});
+    level.head = static_cast<block_id_type>(index);
+    set_bit(level.free, index);
+  }
+
+  void pop_free(size_t order, size_t index) noexcept
+  {
+    auto & level = _levels[order];
+    auto node = load_links(order, index);
+    if (node.prev != npos)
+    {
+      auto prev = load_links(order, node.prev);
+      prev.next = node.next;
+      store_links(order, node.prev, prev);
+    }
+    else
+    {
+      level.head = node.next;
+    }
+
+    if (node.next != npos)
+    {
+      auto next = load_links(order, node.next);
+      next.prev = node.prev;
+      store_links(order, node.next, next);
+    }
+    reset_bit(level.free, index);
+  }
+};
+
+} // namespace ac
+
+#endif // BUDDY_ALLOCATOR_HPP
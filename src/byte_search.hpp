@@ -0,0 +1,74 @@
+#ifndef BYTE_SEARCH_HPP
+#define BYTE_SEARCH_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace ac
+{
+
+namespace detail
+{
+
+// Returns index of the first `value` in [buf, buf + len) or `len` if not found
+[[nodiscard]]
+inline size_t find_byte(const std::byte * buf, size_t len, std::byte value) noexcept
+{
+  size_t i = 0;
+#if defined(__AVX2__)
+  const __m256i needle = _mm256_set1_epi8(static_cast<char>(value));
+  for (; i + 32 <= len; i += 32)
+  {
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(buf + i));
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)));
+    if (mask != 0)
+      return i + std::countr_zero(mask);
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128i needle16 = _mm_set1_epi8(static_cast<char>(value));
+  // Four blocks per iteration, the exact position is found only on a hit
+  for (; i + 64 <= len; i += 64)
+  {
+    auto * block = reinterpret_cast<const __m128i *>(buf + i);
+    __m128i eq0 = _mm_cmpeq_epi8(_mm_loadu_si128(block + 0), needle16);
+    __m128i eq1 = _mm_cmpeq_epi8(_mm_loadu_si128(block + 1), needle16);
+    __m128i eq2 = _mm_cmpeq_epi8(_mm_loadu_si128(block + 2), needle16);
+    __m128i eq3 = _mm_cmpeq_epi8(_mm_loadu_si128(block + 3), needle16);
+    __m128i any = _mm_or_si128(_mm_or_si128(eq0, eq1), _mm_or_si128(eq2, eq3));
+    if (_mm_movemask_epi8(any) == 0)
+      continue;
+
+    uint64_t mask = static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(eq0)))
+      | static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(eq1))) << 16
+      | static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(eq2))) << 32
+      | static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(eq3))) << 48;
+    return i + std::countr_zero(mask);
+  }
+  for (; i + 16 <= len; i += 16)
+  {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + i));
+    uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle16)));
+    if (mask != 0)
+      return i + std::countr_zero(mask);
+  }
+#endif
+  for (; i < len; ++i)
+  {
+    if (buf[i] == value)
+      return i;
+  }
+  return len;
+}
+
+} // namespace detail
+
+} // namespace ac
+
+#endif // BYTE_SEARCH_HPP
@@ -0,0 +1,268 @@
+#ifndef CACHED_CHUNK_ALLOCATOR_HPP
+#define CACHED_CHUNK_ALLOCATOR_HPP
+
+#include "ac_concepts.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace ac
+{
+
+// Keeps a small per-thread magazine of chunks in front of a thread-safe
+// allocator (e.g. sync_chunk_allocator or lockfree_chunk_allocator).
+// Chunks freed and allocated on the same thread never reach the backend.
+// An empty magazine is refilled and a full one is flushed by half of its
+// size at once. Magazines are flushed back when their thread exits.
+//
+// A magazine is touched only by its own thread, so allocate() and
+// deallocate() take no locks. trim() flushes the calling thread's magazine
+// and makes other threads flush theirs on their next call. The destructor
+// flushes magazines of all threads, so the backend isn't touched after this
+// object is gone (e.g. when its buffer is freed). Calls from other threads
+// must be finished before it, as with any other object.
+//
+// The backend object is shared with threads that used the allocator, so
+// it's destroyed when the last of them exits, not with this object.
+
+template<IsChunkAllocator Allocator>
+class cached_chunk_allocator
+{
+public:
+  using allocator_type = Allocator;
+  using value_type = typename allocator_type::value_type;
+  using chunk_type = typename allocator_type::chunk_type;
+
+public:
+  template<class ... Args>
+  cached_chunk_allocator(size_t magazine_size, Args &&... args) :
+    _magazine_size{std::max<size_t>(magazine_size, 1)},
+    _id{_next_id.fetch_add(1, std::memory_order_relaxed)},
+    _state{std::make_shared<shared_state>(std::forward<Args>(args)...)}
+  {}
+
+  ~cached_chunk_allocator()
+  {
+    std::lock_guard lock(_state->mutex);
+    _state->alive.store(false, std::memory_order_relaxed);
+    for (auto * it : _state->magazines)
+      flush(*_state, *it, it->chunks.size());
+  }
+
+  cached_chunk_allocator(const cached_chunk_allocator &) = delete;
+  cached_chunk_allocator & operator =(const cached_chunk_allocator &) = delete;
+
+  [[nodiscard]]
+  chunk_type allocate()
+  {
+    magazine & mag = local_magazine();
+    check_trim(mag);
+    if (mag.chunks.empty() && refill(mag) == 0)
+      return {};
+
+    auto ret = mag.chunks.back();
+    mag.chunks.pop_back();
+    mag.cached.store(mag.chunks.size(), std::memory_order_relaxed);
+    return ret;
+  }
+
+  // Chunk MUST be allocated by this allocator, it's validated by the
+  // backend only when the magazine is flushed
+  void deallocate(chunk_type chunk)
+  {
+    if (chunk.empty())
+      return;
+
+    magazine & mag = local_magazine();
+    check_trim(mag);
+    if (mag.chunks.size() >= _magazine_size)
+      flush(*_state, mag, batch_size());
+
+    mag.chunks.push_back(chunk);
+    mag.cached.store(mag.chunks.size(), std::memory_order_relaxed);
+  }
+
+  // Returns chunks cached by this thread to the backend, other threads
+  // return theirs on their next allocate() or deallocate()
+  void trim()
+  {
+    _state->trim_epoch.fetch_add(1, std::memory_order_relaxed);
+    check_trim(local_magazine());
+  }
+
+  size_t size() const noexcept { return _state->allocator.size(); }
+
+  // Magazines change while the sum is taken, so values are clamped
+  size_t remain() const noexcept
+  {
+    return std::min(_state->allocator.remain() + cached(), size());
+  }
+
+  size_t in_use() const noexcept
+  {
+    size_t used = _state->allocator.in_use();
+    size_t cached = this->cached();
+    return used > cached ? used - cached : 0;
+  }
+
+  // Count of chunks kept in magazines of all threads
+  size_t cached() const noexcept
+  {
+    std::lock_guard lock(_state->mutex);
+    size_t ret = 0;
+    for (auto * it : _state->magazines)
+      ret += it->cached.load(std::memory_order_relaxed);
+    return ret;
+  }
+
+  size_t magazine_size() const noexcept { return _magazine_size; }
+
+private:
+  struct magazine
+  {
+    std::vector<chunk_type> chunks;
+    std::atomic<size_t> cached{0};
+    uint64_t trim_epoch{0};
+  };
+
+  struct shared_state
+  {
+    template<class ... Args>
+    explicit shared_state(Args &&... args) :
+      allocator{std::forward<Args>(args)...}
+    {}
+
+    allocator_type allocator;
+    std::atomic<bool> alive{true};
+    std::atomic<uint64_t> trim_epoch{0};
+    mutable std::mutex mutex;
+    std::vector<magazine *> magazines;
+  };
+
+  struct thread_entry
+  {
+    uint64_t id;
+    std::shared_ptr<shared_state> state;
+    std::unique_ptr<magazine> mag;
+  };
+
+  struct thread_cache
+  {
+    std::vector<thread_entry> entries;
+    size_t last{0};
+
+    ~thread_cache()
+    {
+      for (auto & it : entries)
+        release(it);
+    }
+  };
+
+  inline static std::atomic<uint64_t> _next_id{0};
+
+  const size_t _magazine_size;
+  const uint64_t _id;
+  std::shared_ptr<shared_state> _state;
+
+  size_t batch_size() const noexcept
+  {
+    return std::max<size_t>(_magazine_size / 2, 1);
+  }
+
+  static thread_cache & local_cache()
+  {
+    static thread_local thread_cache cache;
+    return cache;
+  }
+
+  magazine & local_magazine()
+  {
+    auto & cache = local_cache();
+    if (cache.last < cache.entries.size() && cache.entries[cache.last].id == _id)
+      return *cache.entries[cache.last].mag;
+
+    for (size_t i = 0; i < cache.entries.size(); ++i)
+    {
+      if (cache.entries[i].id == _id)
+      {
+        cache.last = i;
+        return *cache.entries[i].mag;
+      }
+    }
+    return register_thread(cache);
+  }
+
+  magazine & register_thread(thread_cache & cache)
+  {
+    // Drop the entries of destroyed allocators first
+    std::erase_if(cache.entries, [](thread_entry & it)
+    {
+      if (it.state->alive.load(std::memory_order_relaxed))
+        return false;
+      release(it);
+      return true;
+    });
+
+    thread_entry entry{_id, _state, std::make_unique<magazine>()};
+    entry.mag->chunks.reserve(_magazine_size);
+    entry.mag->trim_epoch = _state->trim_epoch.load(std::memory_order_relaxed);
+    {
+      std::lock_guard lock(_state->mutex);
+      _state->magazines.push_back(entry.mag.get());
+    }
+    cache.entries.push_back(std::move(entry));
+    cache.last = cache.entries.size() - 1;
+    return *cache.entries.back().mag;
+  }
+
+  // The magazine of a destroyed allocator was flushed by its destructor
+  static void release(thread_entry & entry)
+  {
+    std::lock_guard lock(entry.state->mutex);
+    if (entry.state->alive.load(std::memory_order_relaxed))
+      flush(*entry.state, *entry.mag, entry.mag->chunks.size());
+    std::erase(entry.state->magazines, entry.mag.get());
+  }
+
+  // The epoch is written only by trim(), so reading it keeps the cache line
+  // shared between threads
+  void check_trim(magazine & mag)
+  {
+    uint64_t epoch = _state->trim_epoch.load(std::memory_order_relaxed);
+    if (mag.trim_epoch == epoch)
+      return;
+
+    mag.trim_epoch = epoch;
+    flush(*_state, mag, mag.chunks.size());
+  }
+
+  size_t refill(magazine & mag)
+  {
+    mag.chunks.resize(batch_size());
+    size_t count = ac::allocate_n(_state->allocator, std::span{mag.chunks});
+    mag.chunks.resize(count);
+    mag.cached.store(mag.chunks.size(), std::memory_order_relaxed);
+    return mag.chunks.size();
+  }
+
+  // Returns `count` least recently freed chunks to the backend
+  static void flush(shared_state & state, magazine & mag, size_t count)
+  {
+    count = std::min(count, mag.chunks.size());
+    if (count == 0)
+      return;
+    ac::deallocate_n(state.allocator,
+                     std::span<const chunk_type>{mag.chunks.data(), count});
+    mag.chunks.erase(mag.chunks.begin(), mag.chunks.begin() + count);
+    mag.cached.store(mag.chunks.size(), std::memory_order_relaxed);
+  }
+};
+
+} // namespace ac
+
+#endif // CACHED_CHUNK_ALLOCATOR_HPP
@@ -3,16 +3,114 @@
 
 #include "static_chunk_allocator.hpp"
 #include "ac_concepts.hpp"
+#include "byte_search.hpp"
 #include <cstddef>
 #include <algorithm>
+#include <bit>
 #include <cstring>
 #include <iostream>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include <cassert>
+
+#ifdef __linux__
+#include <sys/uio.h>
+#endif
 
 namespace ac
 {
 
+namespace detail
+{
+
+// Ring of chunks, so chunks can be released from the front in O(1)
+template<class T>
+class chunk_ring
+{
+public:
+  size_t size() const noexcept { return _size; }
+  bool empty() const noexcept { return _size == 0; }
+
+  T & operator [](size_t i) noexcept { return _buf[(_head + i) & _mask]; }
+  const T & operator [](size_t i) const noexcept { return _buf[(_head + i) & _mask]; }
+
+  T & front() noexcept { return (*this)[0]; }
+  const T & front() const noexcept { return (*this)[0]; }
+
+  void reserve(size_t count)
+  {
+    if (count <= _buf.size())
+      return;
+
+    std::vector<T> buf(std::bit_ceil(count));
+    for (size_t i = 0; i < _size; ++i)
+      buf[i] = (*this)[i];
+    _buf = std::move(buf);
+    _head = 0;
+    _mask = _buf.size() - 1;
+  }
+
+  void push_back(const T & val)
+  {
+    reserve(_size + 1);
+    (*this)[_size] = val;
+    ++_size;
+  }
+
+  // Contiguous free slots right after the last element
+  std::span<T> back_space() noexcept
+  {
+    size_t tail = (_head + _size) & _mask;
+    return {_buf.data() + tail, std::min(_buf.size() - _size, _buf.size() - tail)};
+  }
+
+  // Appends `count` elements placed to back_space()
+  void commit_back(size_t count) noexcept
+  {
+    _size += count;
+  }
+
+  // Contiguous elements starting from the first one
+  std::span<T> front_span() noexcept
+  {
+    return {_buf.data() + _head, std::min(_size, _buf.size() - _head)};
+  }
+
+  void pop_front(size_t count) noexcept
+  {
+    _head = (_head + count) & _mask;
+    _size -= count;
+  }
+
+  void pop_back(size_t count) noexcept
+  {
+    _size -= count;
+  }
+
+  void clear() noexcept
+  {
+    _head = 0;
+    _size = 0;
+  }
+
+private:
+  std::vector<T> _buf;
+  size_t _head{0};
+  size_t _size{0};
+  size_t _mask{0};
+};
+
+} // namespace detail
+
 // The work of this class is to allocate and manipulate the chunks of memory.
 // It provides easy interface to write and read data to/from it.
+// Data may be consumed from the front, so it works as a FIFO stream buffer
+// where fully consumed chunks go back to the allocator immediately.
+// It's a random-access range of bytes, segments() is a range of
+// contiguous pieces for code that processes whole blocks at once.
 
 template<IsChunkAllocator Allocator>
 class chunk_list_wrapper
@@ -21,12 +119,26 @@ public:
   using allocator_type = Allocator;
   using value_type = typename allocator_type::value_type;
   using chunk_type = typename allocator_type::chunk_type;
+  using segment_type = std::span<value_type>;
+  using const_segment_type = std::span<const value_type>;
+
+  template<bool Const>
+  class basic_iterator;
+  template<bool Const>
+  class basic_segment_iterator;
+
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+  using segment_iterator = basic_segment_iterator<false>;
+  using const_segment_iterator = basic_segment_iterator<true>;
+
+  static constexpr size_t npos = static_cast<size_t>(-1);
 
   explicit
     chunk_list_wrapper(allocator_type & allocator) :
     _allocator(allocator),
-    _size(0),
-    _last_chunk_remain(0)
+    _head(0),
+    _size(0)
   {}
 
   ~chunk_list_wrapper()
@@ -37,21 +149,22 @@ public:
   [[nodiscard]]
   size_t write(const value_type * buf, size_t len)
   {
-    size_t orig_len = len;
-
-    if (_last_chunk_remain != 0)
-    {
-      write_to_last(buf, len);
-    }
+    reserve_tail(len);
+    len = std::min(len, remain());
 
-    while (len > 0)
+    const size_t end = _head + _size;
+    size_t pos = end;
+    size_t rem = 0;
+    value_type * write_buf = nullptr;
+    while ((rem = contiguous(pos, write_buf, len - (pos - end))) != 0)
     {
-      if (allocate_next() == false)
-        break;
-      write_to_last(buf, len);
+      ::memcpy(write_buf, buf, rem);
+      buf += rem;
+      pos += rem;
     }
 
-    return (orig_len - len);
+    _size += len;
+    return len;
   }
 
   [[nodiscard]]
@@ -80,53 +193,409 @@ public:
   [[nodiscard]]
   size_t read(size_t offset, value_type *& buf, size_t len)
   {
-    if (offset >= size() || _chunks.empty())
+    if (offset >= size())
       return 0;
+    return contiguous(_head + offset, buf, std::min(len, size() - offset));
+  }
 
-    //We pretend that there are consecutive chunks of memory
-    //Also chunks MUST be always be the same size
-    size_t chunk_size = _chunks.front().size();
-    size_t chunk_id = offset / chunk_size;
-    if (chunk_id >= _chunks.size())
+  // Fills `out` with pieces of data in range [offset, offset + len),
+  // returns count of filled segments
+  [[nodiscard]]
+  size_t readable_segments(size_t offset, size_t len, std::span<segment_type> out) const
+  {
+    if (offset >= size())
       return 0;
+    return fill_segments(_head + offset, std::min(len, size() - offset), out,
+                         [](value_type * buf, size_t rem) { return segment_type{buf, rem}; });
+  }
 
-    offset = offset % chunk_size;
+  // Allocates chunks for up to `len` bytes after the data, fills `out` with
+  // the writable pieces and returns count of filled segments.
+  // Data written there becomes visible after commit()
+  [[nodiscard]]
+  size_t writable_segments(size_t len, std::span<segment_type> out)
+  {
+    reserve_tail(len);
+    return fill_segments(_head + _size, std::min(len, remain()), out,
+                         [](value_type * buf, size_t rem) { return segment_type{buf, rem}; });
+  }
 
-    auto chunk = _chunks[chunk_id];
-    if (offset >= chunk.size())
+#ifdef __linux__
+  [[nodiscard]]
+  size_t readable_segments(size_t offset, size_t len, std::span<iovec> out) const
+  {
+    if (offset >= size())
       return 0;
+    return fill_segments(_head + offset, std::min(len, size() - offset), out, make_iovec);
+  }
 
-    buf = std::addressof(chunk.data()[offset]);
-    if (chunk_id == _chunks.size() - 1 && _last_chunk_remain)
-      chunk_size -= _last_chunk_remain;
-    return std::min(chunk_size - offset, len);
+  [[nodiscard]]
+  size_t writable_segments(size_t len, std::span<iovec> out)
+  {
+    reserve_tail(len);
+    return fill_segments(_head + _size, std::min(len, remain()), out, make_iovec);
+  }
+#endif // __linux__
+
+  // Returns writable memory right after the data for in-place encoding.
+  // At least `min_len` bytes after the data are allocated, the span is the
+  // contiguous part of them up to the chunk boundary, so it's shorter than
+  // `min_len` when the data ends close to the boundary: commit what fits
+  // and call again to get the next chunk. The data is never moved.
+  // Empty span means that allocator can't provide `min_len` bytes
+  [[nodiscard]]
+  segment_type reserve(size_t min_len = 1)
+  {
+    min_len = std::max<size_t>(min_len, 1);
+    reserve_tail(min_len);
+    if (remain() < min_len)
+      return {};
+
+    value_type * buf = nullptr;
+    size_t rem = contiguous(_head + _size, buf, remain());
+    return segment_type{buf, rem};
+  }
+
+  // Appends `len` bytes already placed after the data
+  // by reserve() or writable_segments()
+  void commit(size_t len) noexcept
+  {
+    _size += std::min(len, remain());
+  }
+
+  // Moves up to `len` bytes from the front of `src` to the end of this one.
+  // Whole chunks are relinked without copying if both use the same allocator
+  // and the data end here has the same offset in a chunk as the data start
+  // in `src` (e.g. either side is empty or chunk-aligned), only bytes of
+  // partially moved chunks are copied. Returns count of moved bytes
+  size_t append(chunk_list_wrapper & src, size_t len)
+  {
+    len = std::min(len, src.size());
+    if (&src == this || len == 0)
+      return 0;
+    if (&_allocator != &src._allocator)
+      return copy_from(src, len);
+
+    const size_t chunk_size = src.chunk_size();
+    size_t moved = 0;
+    if (_size == 0)
+    {
+      clear();
+    }
+    else if (const size_t end = (_head + _size) % chunk_size; end != src._head)
+    {
+      return copy_from(src, len);
+    }
+    else if (end != 0)
+    {
+      // Both sides become chunk-aligned after the last chunk is filled up
+      moved = copy_from(src, std::min(len, chunk_size - end));
+      if (moved == len)
+        return moved;
+    }
+    release_spare();
+
+    const size_t left = len - moved;
+    // The last chunk may be taken partially filled only if all data is moved
+    const size_t chunks_count = left == src._size
+      ? (src._head + left + chunk_size - 1) / chunk_size
+      : (src._head + left) / chunk_size;
+    if (chunks_count > 0)
+    {
+      if (_size == 0)
+        _head = src._head;
+
+      const size_t bytes = std::min(left, chunks_count * chunk_size - src._head);
+      _chunks.reserve(_chunks.size() + chunks_count);
+      for (size_t i = 0; i < chunks_count; ++i)
+        _chunks.push_back(src._chunks[i]);
+      src._chunks.pop_front(chunks_count);
+
+      _size += bytes;
+      src._size -= bytes;
+      src._head = 0;
+      moved += bytes;
+    }
+
+    return moved + copy_from(src, len - moved);
+  }
+
+  size_t append(chunk_list_wrapper && src)
+  {
+    return append(src, src.size());
+  }
+
+  // Drops up to `len` bytes from the front of the data, offsets of the
+  // rest are shifted by that amount. Returns count of dropped bytes
+  size_t consume(size_t len)
+  {
+    len = std::min(len, _size);
+    _head += len;
+    _size -= len;
+
+    const size_t chunk_size = this->chunk_size();
+    if (chunk_size == 0)
+      return len;
+
+    release_front(_head / chunk_size);
+    _head %= chunk_size;
+    // The rest of the chunk may be written again
+    if (_size == 0)
+      _head = 0;
+    return len;
   }
 
   void clear()
   {
-    for (auto & it : _chunks)
-      _allocator.deallocate(it);
+    release_front(_chunks.size());
+    _chunks.clear();
+    _head = 0;
     _size = 0;
-    _last_chunk_remain = 0;
+  }
+
+  // Chunks and the offset of the data in the first one describe the data
+  // completely, so it can be kept without the wrapper (e.g. by
+  // persistent_chunk_pool) and taken back by adopt()
+  size_t chunks_count() const noexcept { return _chunks.size(); }
+  chunk_type chunk_at(size_t index) const noexcept { return _chunks[index]; }
+  size_t head_offset() const noexcept { return _head; }
+
+  // Forgets the chunks without returning them to the allocator
+  void release() noexcept
+  {
+    _chunks.clear();
+    _head = 0;
+    _size = 0;
+  }
+
+  // Replaces the data by `size` bytes at offset `head` of `chunks`,
+  // which MUST be allocated by the same allocator
+  void adopt(std::span<const chunk_type> chunks, size_t head, size_t size)
+  {
+    clear();
+    _chunks.reserve(chunks.size());
+    for (auto & it : chunks)
+      _chunks.push_back(it);
+    _head = head;
+    _size = size;
+    assert(_head + _size <= capacity() && "Data MUST fit the chunks");
+  }
+
+  // Returns offset of the first `value` starting from `from`, or npos
+  [[nodiscard]]
+  size_t find(value_type value, size_t from = 0) const noexcept
+  {
+    value_type * buf = nullptr;
+    size_t rem = 0;
+    for (size_t pos = from; pos < _size; pos += rem)
+    {
+      rem = contiguous(_head + pos, buf, _size - pos);
+      size_t found = detail::find_byte(buf, rem, value);
+      if (found != rem)
+        return pos + found;
+    }
+    return npos;
+  }
+
+  // Returns offset of the first occurrence of `pattern` starting from
+  // `from`, or npos. The occurrence may straddle several chunks
+  [[nodiscard]]
+  size_t find(std::span<const value_type> pattern, size_t from = 0) const noexcept
+  {
+    if (pattern.empty())
+      return from <= _size ? from : npos;
+
+    for (size_t pos = find(pattern.front(), from); pos != npos; pos = find(pattern.front(), pos + 1))
+    {
+      if (_size - pos < pattern.size())
+        break;
+      if (equal_at(pos + 1, pattern.subspan(1)))
+        return pos;
+    }
+    return npos;
+  }
+
+  iterator begin() noexcept { return iterator{this, 0}; }
+  iterator end() noexcept { return iterator{this, _size}; }
+  const_iterator begin() const noexcept { return const_iterator{this, 0}; }
+  const_iterator end() const noexcept { return const_iterator{this, _size}; }
+
+  std::ranges::subrange<segment_iterator> segments() noexcept
+  {
+    return {segment_iterator{this, 0}, segment_iterator{this, segments_count()}};
+  }
+
+  std::ranges::subrange<const_segment_iterator> segments() const noexcept
+  {
+    return {const_segment_iterator{this, 0}, const_segment_iterator{this, segments_count()}};
   }
 
   constexpr size_t size() const noexcept { return _size; }
-  constexpr size_t remain() const noexcept { return _last_chunk_remain; }
+  // Bytes that can be written without allocation of new chunks
+  constexpr size_t remain() const noexcept { return capacity() - _head - _size; }
 
 private:
   allocator_type & _allocator;
-  std::vector<chunk_type> _chunks;
+  detail::chunk_ring<chunk_type> _chunks;
+  // Offset of the data in the first chunk
+  size_t _head;
   size_t _size;
-  size_t _last_chunk_remain;
 
-  void write_to_last(const value_type *& buf, size_t & len)
+  // A constant for allocators like fixed_chunk_allocator, so divisions
+  // and modulos by it are folded into shifts and masks by the compiler
+  constexpr size_t chunk_size() const noexcept
   {
-    auto last = _chunks.back();
-    auto write_size = std::min(_last_chunk_remain, len);
-    ::memcpy(last.data() + (last.size() - _last_chunk_remain), buf, write_size);
-    buf += write_size;
-    len -= write_size;
-    _last_chunk_remain -= write_size;
+    if constexpr (HasStaticChunkSize<allocator_type>)
+      return allocator_type::static_chunk_size;
+    else
+      return _chunks.empty() ? 0 : _chunks.front().size();
+  }
+
+  constexpr size_t capacity() const noexcept
+  {
+    return _chunks.size() * chunk_size();
+  }
+
+  bool equal_at(size_t offset, std::span<const value_type> pattern) const noexcept
+  {
+    value_type * buf = nullptr;
+    while (pattern.empty() == false)
+    {
+      size_t rem = contiguous(_head + offset, buf, pattern.size());
+      if (::memcmp(buf, pattern.data(), rem) != 0)
+        return false;
+      pattern = pattern.subspan(rem);
+      offset += rem;
+    }
+    return true;
+  }
+
+  size_t segments_count() const noexcept
+  {
+    const size_t chunk_size = this->chunk_size();
+    return _size == 0 ? 0 : (_head + _size + chunk_size - 1) / chunk_size;
+  }
+
+  // Data of chunk `index`
+  segment_type segment_at(size_t index) const noexcept
+  {
+    const size_t chunk_size = this->chunk_size();
+    const size_t begin = index == 0 ? _head : 0;
+    const size_t end = std::min(chunk_size, _head + _size - index * chunk_size);
+    return segment_type{_chunks[index].data() + begin, end - begin};
+  }
+
+  // Returns length of contiguous memory at `pos` limited by `len`
+  size_t contiguous(size_t pos, value_type *& buf, size_t len) const
+  {
+    if (len == 0 || pos >= capacity())
+      return 0;
+
+    //We pretend that there are consecutive chunks of memory
+    //Also chunks MUST be always be the same size
+    const size_t chunk_size = this->chunk_size();
+    const size_t chunk_id = pos / chunk_size;
+    const size_t offset = pos % chunk_size;
+
+    buf = std::addressof(_chunks[chunk_id].data()[offset]);
+    return std::min(chunk_size - offset, len);
+  }
+
+  template<class Segment, class MakeSegment>
+  size_t fill_segments(size_t pos, size_t len, std::span<Segment> out,
+                       MakeSegment make_segment) const
+  {
+    size_t count = 0;
+    value_type * buf = nullptr;
+    while (count < out.size())
+    {
+      size_t rem = contiguous(pos, buf, len);
+      if (rem == 0)
+        break;
+      out[count++] = make_segment(buf, rem);
+      pos += rem;
+      len -= rem;
+    }
+    return count;
+  }
+
+#ifdef __linux__
+  static iovec make_iovec(value_type * buf, size_t len) noexcept
+  {
+    return iovec{.iov_base = buf, .iov_len = len};
+  }
+#endif // __linux__
+
+  // Allocates all chunks needed for `len` bytes after the data at once
+  void reserve_tail(size_t len)
+  {
+    if (len <= remain())
+      return;
+
+    // Size of chunks is unknown until the first one is allocated
+    if (_chunks.empty() && allocate_next() == false)
+      return;
+    if (len <= remain())
+      return;
+
+    const size_t chunk_size = this->chunk_size();
+    size_t need = (len - remain() + chunk_size - 1) / chunk_size;
+    _chunks.reserve(_chunks.size() + need);
+
+    while (need > 0)
+    {
+      auto space = _chunks.back_space();
+      space = space.first(std::min(need, space.size()));
+      size_t count = ac::allocate_n(_allocator, space);
+      _chunks.commit_back(count);
+      if (count < space.size())
+        break;
+      need -= count;
+    }
+  }
+
+  // Returns chunks allocated after the end of the data
+  void release_spare()
+  {
+    if (_chunks.empty())
+      return;
+
+    const size_t chunk_size = this->chunk_size();
+    const size_t used = (_head + _size + chunk_size - 1) / chunk_size;
+    for (size_t i = used; i < _chunks.size(); ++i)
+      _allocator.deallocate(_chunks[i]);
+    _chunks.pop_back(_chunks.size() - used);
+  }
+
+  size_t copy_from(chunk_list_wrapper & src, size_t len)
+  {
+    size_t moved = 0;
+    value_type * buf = nullptr;
+    while (moved < len)
+    {
+      size_t rem = src.read(0, buf, len - moved);
+      if (rem == 0)
+        break;
+
+      size_t written = write(buf, rem);
+      src.consume(written);
+      moved += written;
+      if (written < rem)
+        break;
+    }
+    return moved;
+  }
+
+  void release_front(size_t count)
+  {
+    while (count > 0)
+    {
+      auto front = _chunks.front_span();
+      front = front.first(std::min(count, front.size()));
+      ac::deallocate_n(_allocator, std::span<const chunk_type>{front});
+      _chunks.pop_front(front.size());
+      count -= front.size();
+    }
   }
 
   bool allocate_next()
@@ -135,10 +604,188 @@ private:
     if (next.empty())
       return false;
     _chunks.push_back(next);
-    _last_chunk_remain = next.size();
-    _size += next.size();
     return true;
   }
+
+public:
+  // Walks over bytes as if they were in one buffer. Stepping forward within
+  // a chunk is a pointer increment, the chunk is looked up on other moves
+  template<bool Const>
+  class basic_iterator
+  {
+  public:
+    using iterator_concept = std::random_access_iterator_tag;
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = typename chunk_list_wrapper::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+    using reference = std::conditional_t<Const, const value_type &, value_type &>;
+    using owner_type = std::conditional_t<Const, const chunk_list_wrapper, chunk_list_wrapper>;
+
+    basic_iterator() = default;
+    basic_iterator(owner_type * owner, size_t pos) noexcept :
+      _owner(owner),
+      _pos(pos)
+    {}
+
+    operator basic_iterator<true>() const noexcept requires (Const == false)
+    {
+      return basic_iterator<true>{_owner, _pos};
+    }
+
+    reference operator *() const noexcept
+    {
+      if (_left == 0)
+        resolve();
+      return *_ptr;
+    }
+
+    pointer operator ->() const noexcept { return std::addressof(**this); }
+    reference operator [](difference_type n) const noexcept { return *(*this + n); }
+
+    basic_iterator & operator ++() noexcept
+    {
+      ++_pos;
+      if (_left > 1)
+      {
+        ++_ptr;
+        --_left;
+      }
+      else
+      {
+        _left = 0;
+      }
+      return *this;
+    }
+
+    basic_iterator operator ++(int) noexcept
+    {
+      auto ret = *this;
+      ++*this;
+      return ret;
+    }
+
+    basic_iterator & operator --() noexcept { return *this -= 1; }
+
+    basic_iterator operator --(int) noexcept
+    {
+      auto ret = *this;
+      --*this;
+      return ret;
+    }
+
+    basic_iterator & operator +=(difference_type n) noexcept
+    {
+      _pos += n;
+      _left = 0;
+      return *this;
+    }
+
+    basic_iterator & operator -=(difference_type n) noexcept { return *this += -n; }
+
+    friend basic_iterator operator +(basic_iterator it, difference_type n) noexcept { return it += n; }
+    friend basic_iterator operator +(difference_type n, basic_iterator it) noexcept { return it += n; }
+    friend basic_iterator operator -(basic_iterator it, difference_type n) noexcept { return it -= n; }
+
+    friend difference_type operator -(const basic_iterator & lhs, const basic_iterator & rhs) noexcept
+    {
+      return static_cast<difference_type>(lhs._pos) - static_cast<difference_type>(rhs._pos);
+    }
+
+    friend bool operator ==(const basic_iterator & lhs, const basic_iterator & rhs) noexcept
+    {
+      return lhs._pos == rhs._pos;
+    }
+
+    friend auto operator <=>(const basic_iterator & lhs, const basic_iterator & rhs) noexcept
+    {
+      return lhs._pos <=> rhs._pos;
+    }
+
+    // Offset of the byte in the data
+    size_t offset() const noexcept { return _pos; }
+
+  private:
+    owner_type * _owner{nullptr};
+    size_t _pos{0};
+    mutable pointer _ptr{nullptr};
+    // Bytes left in the chunk starting from _ptr
+    mutable size_t _left{0};
+
+    void resolve() const noexcept
+    {
+      value_type * buf = nullptr;
+      _left = _owner->contiguous(_owner->_head + _pos, buf, _owner->_size - _pos);
+      _ptr = buf;
+    }
+  };
+
+  template<bool Const>
+  class basic_segment_iterator
+  {
+  public:
+    using iterator_concept = std::random_access_iterator_tag;
+    using iterator_category = std::input_iterator_tag;
+    using value_type = std::conditional_t<Const, const_segment_type, segment_type>;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type;
+    using owner_type = std::conditional_t<Const, const chunk_list_wrapper, chunk_list_wrapper>;
+
+    basic_segment_iterator() = default;
+    basic_segment_iterator(owner_type * owner, size_t index) noexcept :
+      _owner(owner),
+      _index(index)
+    {}
+
+    reference operator *() const noexcept { return _owner->segment_at(_index); }
+    reference operator [](difference_type n) const noexcept { return *(*this + n); }
+
+    basic_segment_iterator & operator ++() noexcept { ++_index; return *this; }
+    basic_segment_iterator & operator --() noexcept { --_index; return *this; }
+
+    basic_segment_iterator operator ++(int) noexcept
+    {
+      auto ret = *this;
+      ++_index;
+      return ret;
+    }
+
+    basic_segment_iterator operator --(int) noexcept
+    {
+      auto ret = *this;
+      --_index;
+      return ret;
+    }
+
+    basic_segment_iterator & operator +=(difference_type n) noexcept { _index += n; return *this; }
+    basic_segment_iterator & operator -=(difference_type n) noexcept { _index -= n; return *this; }
+
+    friend basic_segment_iterator operator +(basic_segment_iterator it, difference_type n) noexcept { return it += n; }
+    friend basic_segment_iterator operator +(difference_type n, basic_segment_iterator it) noexcept { return it += n; }
+    friend basic_segment_iterator operator -(basic_segment_iterator it, difference_type n) noexcept { return it -= n; }
+
+    friend difference_type operator -(const basic_segment_iterator & lhs,
+                                      const basic_segment_iterator & rhs) noexcept
+    {
+      return static_cast<difference_type>(lhs._index) - static_cast<difference_type>(rhs._index);
+    }
+
+    friend bool operator ==(const basic_segment_iterator & lhs,
+                            const basic_segment_iterator & rhs) noexcept
+    {
+      return lhs._index == rhs._index;
+    }
+
+    friend auto operator <=>(const basic_segment_iterator & lhs,
+                             const basic_segment_iterator & rhs) noexcept
+    {
+      return lhs._index <=> rhs._index;
+    }
+
+  private:
+    owner_type * _owner{nullptr};
+    size_t _index{0};
+  };
 };
 
 } // namespace ac
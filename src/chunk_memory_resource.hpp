@@ -0,0 +1,180 @@
+#ifndef CHUNK_MEMORY_RESOURCE_HPP
+#define CHUNK_MEMORY_RESOURCE_HPP
+
+#include "ac_concepts.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <cassert>
+
+namespace ac
+{
+
+// std::pmr::memory_resource over a chunk allocator, so pmr containers take
+// their nodes from the pool. Every request of up to `chunk_size` bytes gets
+// a whole chunk, bigger or over-aligned requests (e.g. bucket arrays of
+// unordered containers) go to the upstream resource. std::bad_alloc is
+// thrown when the allocator runs out of chunks.
+//
+// The real chunk size is taken once, in the constructor: it's static or
+// one chunk is taken and given back, so the allocator MUST have a free
+// chunk then, otherwise all requests go upstream. `chunk_size` is clamped
+// to it. A misaligned chunk is given back and std::bad_alloc is thrown,
+// the request can't go upstream, as deallocation is routed by the request
+// only. Thread-safe if the allocator is. The allocator MUST outlive the
+// resource.
+
+template<IsChunkAllocator Allocator>
+class chunk_memory_resource final : public std::pmr::memory_resource
+{
+public:
+  using allocator_type = Allocator;
+  using value_type = typename allocator_type::value_type;
+  using chunk_type = typename allocator_type::chunk_type;
+
+public:
+  chunk_memory_resource(allocator_type & allocator, size_t chunk_size,
+                        std::pmr::memory_resource * upstream = std::pmr::get_default_resource()) :
+    _allocator(allocator),
+    _upstream(upstream),
+    _real_chunk_size(real_chunk_size(allocator)),
+    _chunk_size(std::min(chunk_size, _real_chunk_size))
+  {}
+
+  explicit
+    chunk_memory_resource(allocator_type & allocator,
+                          std::pmr::memory_resource * upstream = std::pmr::get_default_resource())
+    requires HasStaticChunkSize<allocator_type> :
+    chunk_memory_resource(allocator, allocator_type::static_chunk_size, upstream)
+  {}
+
+  allocator_type & allocator() const noexcept { return _allocator; }
+  std::pmr::memory_resource * upstream_resource() const noexcept { return _upstream; }
+  size_t chunk_size() const noexcept { return _chunk_size; }
+
+private:
+  template<class, IsChunkAllocator>
+  friend class chunk_stl_allocator;
+
+  allocator_type & _allocator;
+  std::pmr::memory_resource * _upstream;
+  // Size of chunks the allocator hands out, they're given back with it
+  const size_t _real_chunk_size;
+  // The biggest request served by a chunk
+  const size_t _chunk_size;
+
+  static size_t real_chunk_size(allocator_type & allocator)
+  {
+    if constexpr (HasStaticChunkSize<allocator_type>)
+    {
+      return allocator_type::static_chunk_size;
+    }
+    else
+    {
+      auto chunk = allocator.allocate();
+      if (chunk.empty())
+        return 0;
+      allocator.deallocate(chunk);
+      return chunk.size();
+    }
+  }
+
+  // Depends only on the request, so deallocation is routed the same way
+  bool fits_chunk(size_t bytes, size_t alignment) const noexcept
+  {
+    return bytes <= _chunk_size && alignment <= alignof(std::max_align_t);
+  }
+
+  void * allocate_bytes(size_t bytes, size_t alignment)
+  {
+    if (fits_chunk(bytes, alignment) == false)
+      return _upstream->allocate(bytes, alignment);
+
+    auto chunk = _allocator.allocate();
+    if (chunk.empty())
+      throw std::bad_alloc{};
+    assert(chunk.size() == _real_chunk_size && "Chunks MUST be of the same size");
+    if (reinterpret_cast<uintptr_t>(chunk.data()) % alignment != 0)
+    {
+      _allocator.deallocate(chunk);
+      throw std::bad_alloc{};
+    }
+    return chunk.data();
+  }
+
+  void deallocate_bytes(void * ptr, size_t bytes, size_t alignment)
+  {
+    if (fits_chunk(bytes, alignment) == false)
+      return _upstream->deallocate(ptr, bytes, alignment);
+    _allocator.deallocate(chunk_type{static_cast<value_type *>(ptr), _real_chunk_size});
+  }
+
+  void * do_allocate(size_t bytes, size_t alignment) override
+  {
+    return allocate_bytes(bytes, alignment);
+  }
+
+  void do_deallocate(void * ptr, size_t bytes, size_t alignment) override
+  {
+    deallocate_bytes(ptr, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override
+  {
+    return this == &other;
+  }
+};
+
+// Standard allocator for node-based containers (std::list, std::map, ...)
+// over chunk_memory_resource. Unlike std::pmr::polymorphic_allocator the
+// resource type is known, so calls into it aren't virtual. Copies and
+// rebound copies share the resource and compare equal.
+
+template<class T, IsChunkAllocator Allocator>
+class chunk_stl_allocator
+{
+public:
+  using value_type = T;
+  using resource_type = chunk_memory_resource<Allocator>;
+
+  chunk_stl_allocator(resource_type & resource) noexcept :
+    _resource(&resource)
+  {}
+
+  template<class U>
+  chunk_stl_allocator(const chunk_stl_allocator<U, Allocator> & other) noexcept :
+    _resource(other.resource())
+  {}
+
+  [[nodiscard]]
+  T * allocate(size_t count)
+  {
+    if (count > SIZE_MAX / sizeof(T))
+      throw std::bad_array_new_length{};
+    return static_cast<T *>(_resource->allocate_bytes(count * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T * ptr, size_t count) noexcept
+  {
+    _resource->deallocate_bytes(ptr, count * sizeof(T), alignof(T));
+  }
+
+  resource_type * resource() const noexcept { return _resource; }
+
+private:
+  resource_type * _resource;
+};
+
+template<class T, class U, IsChunkAllocator Allocator>
+bool operator ==(const chunk_stl_allocator<T, Allocator> & lhs,
+                 const chunk_stl_allocator<U, Allocator> & rhs) noexcept
+{
+  return lhs.resource() == rhs.resource();
+}
+
+} // namespace ac
+
+#endif // CHUNK_MEMORY_RESOURCE_HPP
@@ -1,36 +1,39 @@
 #ifndef DUMB_CHUNK_ALLOCATOR_HPP
 #define DUMB_CHUNK_ALLOCATOR_HPP
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <span>
 #include <deque>
 #include <memory>
+#include <vector>
 
 namespace ac
 {
 
+// Chunks are carved from slabs, each slab is one heap allocation.
+// Slab sizes grow geometrically from `first_slab_chunks`
+// up to `max_slab_chunks`, but never above the chunk limit.
+struct slab_growth_policy
+{
+  size_t first_slab_chunks = 16;
+  size_t growth_factor = 2;
+  size_t max_slab_chunks = 4096;
+};
+
 namespace detail
 {
 
 template<class Value>
-struct dumb_chunk
+struct dumb_slab
 {
-  using value_type = Value;
-  using chunk_type = std::span<value_type>;
+  std::unique_ptr<Value []> _ptr;
+  size_t _chunks_count;
 
-  std::unique_ptr<value_type []> _ptr;
-  chunk_type _chunk;
+  uintptr_t begin() const noexcept { return reinterpret_cast<uintptr_t>(_ptr.get()); }
 };
 
-
-template<class T>
-[[nodiscard]]
-constexpr bool operator ==(const dumb_chunk<T> & lhs,
-                           const typename dumb_chunk<T>::chunk_type & rhs)
-{
-  return lhs._chunk.data() == rhs.data();
-}
-
 } // namespace detail
 
 class dumb_chunk_allocator
@@ -40,9 +43,11 @@ public:
   using chunk_type = std::span<std::byte>;
 
 public:
-  dumb_chunk_allocator(size_t chunk_size, size_t max_chunks) :
+  dumb_chunk_allocator(size_t chunk_size, size_t max_chunks,
+                       slab_growth_policy policy = {}) :
     _chunk_size{chunk_size},
-    _max_chunks{max_chunks}
+    _max_chunks{max_chunks},
+    _policy{policy}
   {}
 
   [[nodiscard]]
@@ -52,7 +57,7 @@ public:
     {
       if (size() >= _max_chunks)
         return chunk_type{};
-      allocate_next();
+      return carve_next();
     }
     auto ret = _free_chunks.front();
     _free_chunks.pop_front();
@@ -61,32 +66,99 @@ public:
 
   void deallocate(chunk_type chunk)
   {
-    auto it = std::find(_all_chunks.begin(), _all_chunks.end(), chunk);
-    if (it == _all_chunks.end())
+    if (owns(chunk) == false)
       return;
     _free_chunks.push_back(chunk);
   }
 
-  size_t size()   const noexcept { return _all_chunks.size(); }
+  [[nodiscard]]
+  size_t allocate_n(std::span<chunk_type> out)
+  {
+    size_t count = std::min(out.size(), remain());
+    for (size_t i = 0; i < count; ++i)
+      out[i] = allocate();
+    return count;
+  }
+
+  void deallocate_n(std::span<const chunk_type> chunks)
+  {
+    for (auto & it : chunks)
+      deallocate(it);
+  }
+
+  size_t size()   const noexcept { return _carved_chunks; }
   size_t remain() const noexcept { return _max_chunks - size() + _free_chunks.size(); }
   size_t in_use() const noexcept { return size() - _free_chunks.size(); }
 
 private:
-  using internal_chunk = detail::dumb_chunk<value_type>;
+  using slab = detail::dumb_slab<value_type>;
 
   const size_t _chunk_size;
   const size_t _max_chunks;
+  const slab_growth_policy _policy;
   std::deque<chunk_type> _free_chunks;
-  std::deque<internal_chunk> _all_chunks;
+  // Sorted by address to find the owner slab of a chunk
+  std::vector<slab> _slabs;
+  size_t _slabs_capacity{0};
+  size_t _carved_chunks{0};
+  // Uncarved tail of the last allocated slab
+  value_type * _carve_ptr{nullptr};
+  size_t _carve_remain{0};
+  size_t _last_slab_chunks{0};
+
+  chunk_type carve_next()
+  {
+    if (_carve_remain == 0)
+      allocate_slab();
 
-  void allocate_next()
+    chunk_type ret{_carve_ptr, _chunk_size};
+    _carve_ptr += _chunk_size;
+    --_carve_remain;
+    ++_carved_chunks;
+    return ret;
+  }
+
+  void allocate_slab()
   {
-    internal_chunk new_chunk
-      { ._ptr = std::make_unique<value_type []>(_chunk_size) };
-    new_chunk._chunk = chunk_type{new_chunk._ptr.get(), _chunk_size};
+    size_t chunks_count = _last_slab_chunks == 0
+      ? _policy.first_slab_chunks
+      : _last_slab_chunks * _policy.growth_factor;
+    chunks_count = std::clamp<size_t>(chunks_count, 1, std::max<size_t>(_policy.max_slab_chunks, 1));
+    chunks_count = std::min(chunks_count, _max_chunks - _slabs_capacity);
+
+    slab new_slab
+      { ._ptr = std::make_unique_for_overwrite<value_type []>(_chunk_size * chunks_count),
+        ._chunks_count = chunks_count };
+
+    _carve_ptr = new_slab._ptr.get();
+    _carve_remain = chunks_count;
+    _last_slab_chunks = chunks_count;
+    _slabs_capacity += chunks_count;
+
+    auto it = std::upper_bound(_slabs.begin(), _slabs.end(), new_slab.begin(),
+                               [](uintptr_t addr, const slab & s) { return addr < s.begin(); });
+    _slabs.insert(it, std::move(new_slab));
+  }
 
-    _all_chunks.push_back(std::move(new_chunk));
-    _free_chunks.push_back(new_chunk._chunk);
+  bool owns(chunk_type chunk) const noexcept
+  {
+    auto addr = reinterpret_cast<uintptr_t>(chunk.data());
+    auto it = std::upper_bound(_slabs.begin(), _slabs.end(), addr,
+                               [](uintptr_t addr, const slab & s) { return addr < s.begin(); });
+    if (it == _slabs.begin())
+      return false;
+    --it;
+
+    size_t chunk_place = addr - it->begin();
+    if (chunk_place % _chunk_size != 0)
+      return false;
+    if (chunk_place / _chunk_size >= it->_chunks_count)
+      return false;
+
+    // Chunks in uncarved tail were never handed out
+    auto carve_addr = reinterpret_cast<uintptr_t>(_carve_ptr);
+    return _carve_remain == 0 || addr < carve_addr
+      || addr >= carve_addr + _carve_remain * _chunk_size;
   }
 };
 
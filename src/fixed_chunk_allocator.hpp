@@ -0,0 +1,105 @@
+#ifndef FIXED_CHUNK_ALLOCATOR_HPP
+#define FIXED_CHUNK_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <span>
+
+namespace ac
+{
+
+// Compile-time configured alternative to static_chunk_allocator, the buffer
+// is owned by the allocator. Chunk size is a constant, so offset math turns
+// into shifts and masks for power-of-two sizes (and into multiplications
+// otherwise). Constructor is constexpr, so the allocator may be constinit
+// in static storage and used in constant evaluation.
+// Free chunks are reused in LIFO order, the lowest address goes first.
+
+template<size_t ChunkSize, size_t ChunksCount, size_t Alignment = alignof(std::max_align_t)>
+class fixed_chunk_allocator
+{
+  static_assert(ChunkSize > 0, "Chunk MUSTN'T be empty");
+  static_assert(ChunksCount < std::numeric_limits<uint32_t>::max(), "Too many chunks to index");
+  static_assert(std::has_single_bit(Alignment), "Alignment MUST be a power of two");
+
+public:
+  using value_type = std::byte;
+  using chunk_type = std::span<value_type>;
+
+  static constexpr size_t static_chunk_size = ChunkSize;
+  static constexpr size_t static_chunks_count = ChunksCount;
+
+public:
+  constexpr fixed_chunk_allocator() noexcept
+  {
+    for (size_t i = 0; i < ChunksCount; ++i)
+      _free[i] = static_cast<chunk_id_type>(ChunksCount - 1 - i);
+  }
+
+  fixed_chunk_allocator(const fixed_chunk_allocator &) = delete;
+  fixed_chunk_allocator & operator =(const fixed_chunk_allocator &) = delete;
+
+  [[nodiscard]]
+  constexpr chunk_type allocate() noexcept
+  {
+    if (_remain == 0)
+      return {};
+    return chunk_at(_free[--_remain]);
+  }
+
+  constexpr void deallocate(chunk_type chunk) noexcept
+  {
+    std::less<const value_type *> less;
+    if (less(chunk.data(), _buf.data()) || !less(chunk.data(), _buf.data() + _buf.size()))
+      return;
+
+    // Divisor is a constant, so there is no real division here
+    size_t chunk_place = chunk.data() - _buf.data();
+    if (chunk_place % ChunkSize != 0)
+      return;
+    if (_remain == ChunksCount)
+      return;
+
+    _free[_remain++] = static_cast<chunk_id_type>(chunk_place / ChunkSize);
+  }
+
+  [[nodiscard]]
+  constexpr size_t allocate_n(std::span<chunk_type> out) noexcept
+  {
+    size_t count = std::min(out.size(), _remain);
+    for (size_t i = 0; i < count; ++i)
+      out[i] = chunk_at(_free[--_remain]);
+    return count;
+  }
+
+  constexpr void deallocate_n(std::span<const chunk_type> chunks) noexcept
+  {
+    for (auto & it : chunks)
+      deallocate(it);
+  }
+
+  constexpr size_t size()   const noexcept { return ChunksCount; }
+  constexpr size_t remain() const noexcept { return _remain; }
+  constexpr size_t in_use() const noexcept { return size() - remain(); }
+
+private:
+  using chunk_id_type = uint32_t;
+
+  alignas(Alignment) std::array<value_type, ChunkSize * ChunksCount> _buf{};
+  std::array<chunk_id_type, ChunksCount> _free{};
+  size_t _remain{ChunksCount};
+
+  constexpr chunk_type chunk_at(size_t chunk_id) noexcept
+  {
+    return chunk_type{_buf}.subspan(ChunkSize * chunk_id, ChunkSize);
+  }
+};
+
+} // namespace ac
+
+#endif // FIXED_CHUNK_ALLOCATOR_HPP
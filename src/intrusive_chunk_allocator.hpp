@@ -0,0 +1,109 @@
+#ifndef INTRUSIVE_CHUNK_ALLOCATOR_HPP
+#define INTRUSIVE_CHUNK_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <cassert>
+
+namespace ac
+{
+
+// Works over caller-supplied buffer like static_chunk_allocator, but keeps
+// no side table: the id of the next free chunk is stored in the body of the
+// free chunk itself. Chunks that were never handed out are carved lazily
+// from the high-water mark, so construction doesn't touch the buffer.
+// Unlike static_chunk_allocator, freed chunks are reused in LIFO order.
+
+class intrusive_chunk_allocator
+{
+public:
+  using value_type = std::byte;
+  using chunk_type = std::span<value_type>;
+
+public:
+  intrusive_chunk_allocator(value_type * buf, size_t buf_len, size_t chunk_size) :
+    _buf{buf, buf_len}, _chunk_size{chunk_size},
+    _chunks_count{_buf.size_bytes() / _chunk_size},
+    _remain{_chunks_count}
+  {
+    assert((buf_len % chunk_size) == 0 && "There MUSTN'T be the remainder");
+    assert(chunk_size >= sizeof(chunk_id_type) && "Chunk MUST fit the next chunk id");
+    assert(_chunks_count < npos && "Too many chunks to index");
+  }
+
+  [[nodiscard]]
+  chunk_type allocate()
+  {
+    chunk_id_type chunk_id = npos;
+    if (_free_head != npos)
+    {
+      chunk_id = _free_head;
+      _free_head = load_next(chunk_id);
+    }
+    else if (_high_water < _chunks_count)
+    {
+      chunk_id = static_cast<chunk_id_type>(_high_water++);
+    }
+    else
+    {
+      return {};
+    }
+
+    --_remain;
+    return chunk_at(chunk_id);
+  }
+
+  void deallocate(chunk_type chunk)
+  {
+    size_t chunk_place = chunk.data() - _buf.data();
+    if (chunk_place % _chunk_size != 0)
+      return;
+    size_t chunk_id = chunk_place / _chunk_size;
+    if (chunk_id >= _high_water)
+      return;
+
+    store_next(chunk_id, _free_head);
+    _free_head = static_cast<chunk_id_type>(chunk_id);
+    ++_remain;
+  }
+
+  size_t size()   const noexcept { return _chunks_count; }
+  size_t remain() const noexcept { return _remain; }
+  size_t in_use() const noexcept { return size() - remain(); }
+
+private:
+  using chunk_id_type = uint32_t;
+  static constexpr chunk_id_type npos = std::numeric_limits<chunk_id_type>::max();
+
+  chunk_type _buf;
+  const size_t _chunk_size;
+  const size_t _chunks_count;
+  size_t _remain;
+  size_t _high_water{0};
+  chunk_id_type _free_head{npos};
+
+  chunk_type chunk_at(size_t chunk_id) const noexcept
+  {
+    return _buf.subspan(_chunk_size * chunk_id, _chunk_size);
+  }
+
+  // Chunks aren't required to be aligned, so the id is copied bytewise
+  chunk_id_type load_next(size_t chunk_id) const noexcept
+  {
+    chunk_id_type next;
+    ::memcpy(&next, chunk_at(chunk_id).data(), sizeof(next));
+    return next;
+  }
+
+  void store_next(size_t chunk_id, chunk_id_type next) noexcept
+  {
+    ::memcpy(chunk_at(chunk_id).data(), &next, sizeof(next));
+  }
+};
+
+} // namespace ac
+
+#endif // INTRUSIVE_CHUNK_ALLOCATOR_HPP
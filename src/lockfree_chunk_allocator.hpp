@@ -0,0 +1,122 @@
+#ifndef LOCKFREE_CHUNK_ALLOCATOR_HPP
+#define LOCKFREE_CHUNK_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <cassert>
+
+namespace ac
+{
+
+// Thread-safe alternative to sync_chunk_allocator<static_chunk_allocator>.
+// Free chunks form a Treiber stack, the head packs chunk id together with
+// a tag that is bumped on every pop to defeat ABA. Links live in a side
+// array of atomics (4 bytes per chunk), so chunk bodies are never touched.
+// remain() and in_use() are wait-free and may lag behind concurrent calls.
+// A freed chunk is counted before it's pushed, so the counter can't go
+// below zero, it's clamped to size() while the push is in flight.
+
+class lockfree_chunk_allocator
+{
+public:
+  using value_type = std::byte;
+  using chunk_type = std::span<value_type>;
+
+public:
+  lockfree_chunk_allocator(value_type * buf, size_t buf_len, size_t chunk_size) :
+    _buf{buf, buf_len}, _chunk_size{chunk_size},
+    _chunks_count{_buf.size_bytes() / _chunk_size},
+    _next{std::make_unique<std::atomic<chunk_id_type> []>(_chunks_count)},
+    _head{make_head(_chunks_count == 0 ? npos : 0, 0)},
+    _remain{_chunks_count}
+  {
+    assert((buf_len % chunk_size) == 0 && "There MUSTN'T be the remainder");
+    assert(_chunks_count < npos && "Too many chunks to index");
+    for (size_t i = 0; i < _chunks_count; ++i)
+    {
+      chunk_id_type next = i + 1 < _chunks_count ? static_cast<chunk_id_type>(i + 1) : npos;
+      _next[i].store(next, std::memory_order_relaxed);
+    }
+  }
+
+  [[nodiscard]]
+  chunk_type allocate()
+  {
+    uint64_t head = _head.load(std::memory_order_acquire);
+    while (true)
+    {
+      chunk_id_type chunk_id = head_id(head);
+      if (chunk_id == npos)
+        return {};
+
+      // Stale value is fine here, the tag makes the CAS fail in that case
+      chunk_id_type next = _next[chunk_id].load(std::memory_order_relaxed);
+      if (_head.compare_exchange_weak(head, make_head(next, head_tag(head) + 1),
+                                      std::memory_order_acquire,
+                                      std::memory_order_acquire))
+      {
+        _remain.fetch_sub(1, std::memory_order_relaxed);
+        return _buf.subspan(_chunk_size * chunk_id, _chunk_size);
+      }
+    }
+  }
+
+  void deallocate(chunk_type chunk)
+  {
+    size_t chunk_place = chunk.data() - _buf.data();
+    if (chunk_place % _chunk_size != 0)
+      return;
+    size_t chunk_id = chunk_place / _chunk_size;
+    if (chunk_id >= _chunks_count)
+      return;
+
+    // Before the chunk may be popped and counted by another thread
+    _remain.fetch_add(1, std::memory_order_relaxed);
+    uint64_t head = _head.load(std::memory_order_relaxed);
+    do
+    {
+      _next[chunk_id].store(head_id(head), std::memory_order_relaxed);
+    }
+    while (!_head.compare_exchange_weak(head,
+                                        make_head(static_cast<chunk_id_type>(chunk_id), head_tag(head)),
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed));
+  }
+
+  size_t size()   const noexcept { return _chunks_count; }
+  size_t remain() const noexcept { return std::min(_remain.load(std::memory_order_relaxed), _chunks_count); }
+  size_t in_use() const noexcept { return size() - remain(); }
+
+private:
+  using chunk_id_type = uint32_t;
+  static constexpr chunk_id_type npos = std::numeric_limits<chunk_id_type>::max();
+
+  static constexpr uint64_t make_head(chunk_id_type id, uint32_t tag) noexcept
+  {
+    return (uint64_t{tag} << 32) | id;
+  }
+  static constexpr chunk_id_type head_id(uint64_t head) noexcept
+  {
+    return static_cast<chunk_id_type>(head);
+  }
+  static constexpr uint32_t head_tag(uint64_t head) noexcept
+  {
+    return static_cast<uint32_t>(head >> 32);
+  }
+
+  chunk_type _buf;
+  const size_t _chunk_size;
+  const size_t _chunks_count;
+  std::unique_ptr<std::atomic<chunk_id_type> []> _next;
+  alignas(64) std::atomic<uint64_t> _head;
+  alignas(64) std::atomic<size_t> _remain;
+};
+
+} // namespace ac
+
+#endif // LOCKFREE_CHUNK_ALLOCATOR_HPP
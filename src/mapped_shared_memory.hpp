@@ -0,0 +1,345 @@
+#ifdef __linux__
+
+#ifndef MAPPED_SHARED_MEMORY_HPP
+#define MAPPED_SHARED_MEMORY_HPP
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace ac
+{
+
+enum class huge_pages
+{
+  none,
+  // madvise(MADV_HUGEPAGE), works if the kernel allows THP for shmem
+  transparent,
+  // Reserved huge pages (vm.nr_hugepages), memfd_shared_memory only
+  explicit_2mb,
+  explicit_1gb
+};
+
+struct mapping_options
+{
+  huge_pages pages = huge_pages::none;
+  // Fault all pages in at mapping time instead of on the first touch
+  bool populate = false;
+};
+
+namespace detail
+{
+
+inline constexpr size_t huge_page_size(huge_pages pages) noexcept
+{
+  switch (pages)
+  {
+  case huge_pages::explicit_2mb: return size_t{2} << 20;
+  case huge_pages::explicit_1gb: return size_t{1} << 30;
+  default: return 0;
+  }
+}
+
+// Page size for MFD_HUGETLB is log2(size) at bit 26 (<linux/memfd.h>
+// clashes with the glibc definitions)
+inline constexpr unsigned int memfd_huge_flags(huge_pages pages) noexcept
+{
+  switch (pages)
+  {
+  case huge_pages::explicit_2mb: return MFD_HUGETLB | (21u << 26);
+  case huge_pages::explicit_1gb: return MFD_HUGETLB | (30u << 26);
+  default: return 0;
+  }
+}
+
+// Owns a file descriptor and its shared mapping
+class mapped_region
+{
+public:
+  mapped_region() = default;
+
+  mapped_region(const mapped_region &) = delete;
+  mapped_region & operator =(const mapped_region &) = delete;
+
+  ~mapped_region()
+  {
+    reset();
+  }
+
+  // Takes ownership of `fd` even if mapping fails
+  [[nodiscard]]
+  bool map(int fd, size_t size, mapping_options options) noexcept
+  {
+    reset();
+    _fd = fd;
+
+    int flags = MAP_SHARED;
+    if (options.populate)
+      flags |= MAP_POPULATE;
+    void * base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, fd, 0);
+    if (base == MAP_FAILED)
+      return false;
+
+    if (options.pages == huge_pages::transparent)
+      (void)::madvise(base, size, MADV_HUGEPAGE);
+    _base = base;
+    _size = size;
+    return true;
+  }
+
+  void reset() noexcept
+  {
+    if (_base != nullptr)
+      ::munmap(_base, _size);
+    if (_fd != -1)
+      ::close(_fd);
+    _base = nullptr;
+    _size = 0;
+    _fd = -1;
+  }
+
+  int fd() const noexcept { return _fd; }
+  void * base() const noexcept { return _base; }
+  size_t size() const noexcept { return _size; }
+
+private:
+  int _fd{-1};
+  void * _base{nullptr};
+  size_t _size{0};
+};
+
+inline std::optional<size_t> file_size(int fd) noexcept
+{
+  struct stat st;
+  if (::fstat(fd, &st) != 0)
+    return std::nullopt;
+  return static_cast<size_t>(st.st_size);
+}
+
+} // namespace detail
+
+// POSIX shared memory object (shm_open) mapped with mmap. It isn't limited
+// by SysV sysctls, and the object is unlinked when its creator is destroyed,
+// processes that have it mapped keep using it. The name MUST start with '/'.
+// Explicit huge pages aren't supported by shm_open, use memfd_shared_memory.
+
+class posix_shared_memory
+{
+public:
+  posix_shared_memory(std::string name, size_t size, mapping_options options = {}) :
+    _name{std::move(name)},
+    _size{size},
+    _options{options}
+  {}
+
+  ~posix_shared_memory()
+  {
+    if (_owner)
+      (void)unlink();
+  }
+
+  posix_shared_memory(const posix_shared_memory &) = delete;
+  posix_shared_memory & operator =(const posix_shared_memory &) = delete;
+
+  // Creates a new zero-filled object, fails if it already exists
+  [[nodiscard]]
+  bool create() noexcept
+  {
+    if (detail::huge_page_size(_options.pages) != 0)
+      return false;
+
+    int fd = ::shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (fd == -1)
+      return false;
+    _owner = true;
+    if (::ftruncate(fd, static_cast<off_t>(_size)) != 0)
+    {
+      ::close(fd);
+      return false;
+    }
+    return _region.map(fd, _size, _options);
+  }
+
+  // Opens an existing object, its size is taken from the object
+  [[nodiscard]]
+  bool open() noexcept
+  {
+    int fd = ::shm_open(_name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd == -1)
+      return false;
+    auto size = detail::file_size(fd);
+    if (size.has_value() == false || *size == 0)
+    {
+      ::close(fd);
+      return false;
+    }
+    _size = *size;
+    return _region.map(fd, _size, _options);
+  }
+
+  [[nodiscard]]
+  bool create_or_open() noexcept
+  {
+    return create() || open();
+  }
+
+  // The object outlives this one, e.g. to be reattached after restart
+  void keep() noexcept
+  {
+    _owner = false;
+  }
+
+  // Removes the name, mappings stay valid
+  [[nodiscard]]
+  bool unlink() noexcept
+  {
+    _owner = false;
+    return ::shm_unlink(_name.c_str()) == 0;
+  }
+
+  [[nodiscard]]
+  std::optional<void *> get_base_pointer() const noexcept
+  {
+    if (_region.base() == nullptr)
+      return std::nullopt;
+    return _region.base();
+  }
+
+  size_t size() const noexcept { return _size; }
+  int fd() const noexcept { return _region.fd(); }
+
+private:
+  std::string _name;
+  size_t _size;
+  mapping_options _options;
+  bool _owner{false};
+  detail::mapped_region _region;
+};
+
+// Anonymous shared memory (memfd_create), it has no name in the file system
+// and is freed when the last descriptor and mapping are gone, so it never
+// leaks, even on crash. Other processes get it by fork() or by fd passing
+// (send_fd()/receive_fd()). Explicit huge pages round the size up to
+// a huge page and fail if there are not enough reserved ones.
+
+class memfd_shared_memory
+{
+public:
+  memfd_shared_memory(std::string name, size_t size, mapping_options options = {}) :
+    _name{std::move(name)},
+    _size{size},
+    _options{options}
+  {
+    if (size_t page = detail::huge_page_size(options.pages); page != 0)
+      _size = (_size + page - 1) / page * page;
+  }
+
+  memfd_shared_memory(const memfd_shared_memory &) = delete;
+  memfd_shared_memory & operator =(const memfd_shared_memory &) = delete;
+
+  // Creates a new zero-filled memory
+  [[nodiscard]]
+  bool create() noexcept
+  {
+    int fd = ::memfd_create(_name.c_str(), MFD_CLOEXEC | detail::memfd_huge_flags(_options.pages));
+    if (fd == -1)
+      return false;
+    if (::ftruncate(fd, static_cast<off_t>(_size)) != 0)
+    {
+      ::close(fd);
+      return false;
+    }
+    return _region.map(fd, _size, _options);
+  }
+
+  // Maps memory of a descriptor received from another process,
+  // takes ownership of `fd`. The size is taken from the descriptor
+  [[nodiscard]]
+  bool open(int fd) noexcept
+  {
+    auto size = detail::file_size(fd);
+    if (size.has_value() == false || *size == 0)
+    {
+      ::close(fd);
+      return false;
+    }
+    _size = *size;
+    return _region.map(fd, _size, _options);
+  }
+
+  [[nodiscard]]
+  std::optional<void *> get_base_pointer() const noexcept
+  {
+    if (_region.base() == nullptr)
+      return std::nullopt;
+    return _region.base();
+  }
+
+  size_t size() const noexcept { return _size; }
+  int fd() const noexcept { return _region.fd(); }
+
+private:
+  std::string _name;
+  size_t _size;
+  mapping_options _options;
+  detail::mapped_region _region;
+};
+
+// Passes a descriptor over a unix domain socket (SCM_RIGHTS)
+[[nodiscard]]
+inline bool send_fd(int socket, int fd) noexcept
+{
+  char data = 0;
+  iovec iov{.iov_base = &data, .iov_len = sizeof(data)};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] {};
+
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  cmsghdr * cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  ::memcpy(CMSG_DATA(cmsg), &fd, sizeof(fd));
+  return ::sendmsg(socket, &msg, MSG_NOSIGNAL) == sizeof(data);
+}
+
+// Returns the received descriptor, or -1
+[[nodiscard]]
+inline int receive_fd(int socket) noexcept
+{
+  char data = 0;
+  iovec iov{.iov_base = &data, .iov_len = sizeof(data)};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] {};
+
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  if (::recvmsg(socket, &msg, MSG_CMSG_CLOEXEC) != sizeof(data))
+    return -1;
+
+  cmsghdr * cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+    return -1;
+  int fd = -1;
+  ::memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+  return fd;
+}
+
+} // namespace ac
+
+#endif // MAPPED_SHARED_MEMORY_HPP
+
+#endif // __linux__
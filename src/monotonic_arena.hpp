@@ -0,0 +1,174 @@
+#ifndef MONOTONIC_ARENA_HPP
+#define MONOTONIC_ARENA_HPP
+
+#include "ac_concepts.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cassert>
+
+namespace ac
+{
+
+// Position in the arena, allocations made after it are dropped by rewind()
+struct arena_mark
+{
+  size_t chunk_id{0};
+  size_t offset{0};
+};
+
+// Bump allocator for short-lived memory that dies all together (e.g. per
+// request scratch). Memory comes in chunks from the allocator, a request
+// is served by moving the offset in the current chunk, so it's never freed
+// on its own. rewind() drops everything allocated after a mark, marks may
+// be nested. Chunks stay in the arena until reset() returns all of them.
+//
+// A request MUST fit a chunk, bigger ones fail without taking a chunk.
+// Chunks are only guaranteed to be aligned to max_align_t, so a request
+// aligned stronger fails if the padding may not fit. A new chunk that
+// doesn't fit the request is given back at once. Isn't thread-safe.
+
+template<IsChunkAllocator Allocator>
+class monotonic_arena
+{
+public:
+  using allocator_type = Allocator;
+  using value_type = typename allocator_type::value_type;
+  using chunk_type = typename allocator_type::chunk_type;
+
+public:
+  explicit
+    monotonic_arena(allocator_type & allocator) :
+    _allocator(allocator)
+  {}
+
+  monotonic_arena(const monotonic_arena &) = delete;
+  monotonic_arena & operator =(const monotonic_arena &) = delete;
+
+  ~monotonic_arena()
+  {
+    reset();
+  }
+
+  // Returns nullptr if there is no memory
+  [[nodiscard]]
+  void * allocate(size_t len, size_t alignment = alignof(std::max_align_t))
+  {
+    assert(std::has_single_bit(alignment) && "Alignment MUST be a power of two");
+    if (size_t size = chunk_size(); size != 0 && never_fits(size, len, alignment))
+      return nullptr;
+
+    if (_chunk_id < _chunks.size())
+    {
+      if (void * ret = bump(_chunks[_chunk_id], len, alignment))
+        return ret;
+    }
+
+    // Spare chunks are left after rewind(), the rest of the current chunk
+    // is skipped only if the next one fits the request
+    if (_chunk_id + 1 < _chunks.size())
+    {
+      if (padding(_chunks[_chunk_id + 1], 0, alignment) + len > _chunks[_chunk_id + 1].size())
+        return nullptr;
+      _offset = 0;
+      return bump(_chunks[++_chunk_id], len, alignment);
+    }
+
+    auto chunk = _allocator.allocate();
+    if (chunk.empty())
+      return nullptr;
+    if (padding(chunk, 0, alignment) + len > chunk.size())
+    {
+      _allocator.deallocate(chunk);
+      return nullptr;
+    }
+    _chunks.push_back(chunk);
+    _chunk_id = _chunks.size() - 1;
+    _offset = 0;
+    return bump(chunk, len, alignment);
+  }
+
+  // Objects are never destroyed, so they MUST be trivially destructible
+  template<class T, class ... Args>
+  [[nodiscard]]
+  T * create(Args &&... args)
+  {
+    static_assert(std::is_trivially_destructible_v<T>, "Arena never destroys objects");
+    void * place = allocate(sizeof(T), alignof(T));
+    if (place == nullptr)
+      return nullptr;
+    return new (place) T{std::forward<Args>(args)...};
+  }
+
+  arena_mark mark() const noexcept
+  {
+    return arena_mark{_chunk_id, _offset};
+  }
+
+  // Mark MUST be taken from this arena after the last reset()
+  void rewind(arena_mark mark) noexcept
+  {
+    _chunk_id = mark.chunk_id;
+    _offset = mark.offset;
+  }
+
+  void reset()
+  {
+    ac::deallocate_n(_allocator, std::span<const chunk_type>{_chunks});
+    _chunks.clear();
+    _chunk_id = 0;
+    _offset = 0;
+  }
+
+  // Count of chunks held by the arena, including spare ones
+  size_t chunks_count() const noexcept { return _chunks.size(); }
+
+private:
+  allocator_type & _allocator;
+  std::vector<chunk_type> _chunks;
+  // Current chunk and the offset in it
+  size_t _chunk_id{0};
+  size_t _offset{0};
+
+  // Zero until the first chunk is taken, unless it's static
+  size_t chunk_size() const noexcept
+  {
+    if constexpr (HasStaticChunkSize<allocator_type>)
+      return allocator_type::static_chunk_size;
+    else
+      return _chunks.empty() ? 0 : _chunks.front().size();
+  }
+
+  static bool never_fits(size_t chunk_size, size_t len, size_t alignment) noexcept
+  {
+    if (len > chunk_size)
+      return true;
+    return alignment > alignof(std::max_align_t) && len + alignment - 1 > chunk_size;
+  }
+
+  static size_t padding(chunk_type chunk, size_t offset, size_t alignment) noexcept
+  {
+    auto address = reinterpret_cast<uintptr_t>(chunk.data() + offset);
+    return static_cast<size_t>(-address) & (alignment - 1);
+  }
+
+  void * bump(chunk_type chunk, size_t len, size_t alignment) noexcept
+  {
+    size_t pad = padding(chunk, _offset, alignment);
+    if (pad + len > chunk.size() - _offset)
+      return nullptr;
+
+    void * ret = chunk.data() + _offset + pad;
+    _offset += pad + len;
+    return ret;
+  }
+};
+
+} // namespace ac
+
+#endif // MONOTONIC_ARENA_HPP
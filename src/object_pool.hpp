@@ -0,0 +1,172 @@
+#ifndef OBJECT_POOL_HPP
+#define OBJECT_POOL_HPP
+
+#include "ac_concepts.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace ac
+{
+
+// Pool of objects of type T packed into chunks of the allocator, as many
+// as fit a chunk with alignment of T. Free slots form a list linked
+// through the slots themselves, so create() is a list pop (or a bump in
+// the last chunk) and there is no per-object header.
+//
+// Chunks are returned to the allocator only when the pool is destroyed,
+// all objects MUST be destroyed before that. Isn't thread-safe.
+
+template<class T, IsChunkAllocator Allocator>
+class object_pool
+{
+public:
+  using allocator_type = Allocator;
+  using value_type = T;
+  using chunk_type = typename allocator_type::chunk_type;
+
+  class deleter
+  {
+  public:
+    deleter() = default;
+    explicit deleter(object_pool & pool) noexcept :
+      _pool(&pool)
+    {}
+
+    void operator ()(T * ptr) const
+    {
+      _pool->destroy(ptr);
+    }
+
+  private:
+    object_pool * _pool{nullptr};
+  };
+
+  using handle = std::unique_ptr<T, deleter>;
+
+  static constexpr size_t slot_align = std::max(alignof(T), alignof(void *));
+  static constexpr size_t slot_size = (std::max(sizeof(T), sizeof(void *)) + slot_align - 1) / slot_align * slot_align;
+
+public:
+  explicit
+    object_pool(allocator_type & allocator) :
+    _allocator(allocator)
+  {}
+
+  object_pool(const object_pool &) = delete;
+  object_pool & operator =(const object_pool &) = delete;
+
+  ~object_pool()
+  {
+    ac::deallocate_n(_allocator, std::span<const chunk_type>{_chunks});
+  }
+
+  // Returns nullptr if the allocator is out of chunks
+  template<class ... Args>
+  [[nodiscard]]
+  T * create(Args &&... args)
+  {
+    void * slot = take_slot();
+    if (slot == nullptr)
+      return nullptr;
+
+    try
+    {
+      T * ret = new (slot) T(std::forward<Args>(args)...);
+      ++_in_use;
+      return ret;
+    }
+    catch (...)
+    {
+      put_slot(slot);
+      throw;
+    }
+  }
+
+  // Pointer MUST be created by this pool
+  void destroy(T * ptr)
+  {
+    if (ptr == nullptr)
+      return;
+    ptr->~T();
+    put_slot(ptr);
+    --_in_use;
+  }
+
+  // Empty handle if the allocator is out of chunks
+  template<class ... Args>
+  [[nodiscard]]
+  handle make(Args &&... args)
+  {
+    return handle{create(std::forward<Args>(args)...), deleter{*this}};
+  }
+
+  // Count of live objects
+  size_t in_use() const noexcept { return _in_use; }
+  size_t chunks_count() const noexcept { return _chunks.size(); }
+
+private:
+  struct free_slot
+  {
+    free_slot * next;
+  };
+
+  allocator_type & _allocator;
+  std::vector<chunk_type> _chunks;
+  free_slot * _free_head{nullptr};
+  // Never used slots of the last chunk
+  std::byte * _carve_begin{nullptr};
+  std::byte * _carve_end{nullptr};
+  size_t _in_use{0};
+
+  void * take_slot()
+  {
+    if (_free_head != nullptr)
+    {
+      free_slot * ret = _free_head;
+      _free_head = ret->next;
+      ret->~free_slot();
+      return ret;
+    }
+
+    if (static_cast<size_t>(_carve_end - _carve_begin) < slot_size && next_chunk() == false)
+      return nullptr;
+
+    void * ret = _carve_begin;
+    _carve_begin += slot_size;
+    return ret;
+  }
+
+  void put_slot(void * slot) noexcept
+  {
+    _free_head = new (slot) free_slot{_free_head};
+  }
+
+  bool next_chunk()
+  {
+    auto chunk = _allocator.allocate();
+    if (chunk.empty())
+      return false;
+
+    void * place = chunk.data();
+    size_t space = chunk.size();
+    if (std::align(slot_align, slot_size, place, space) == nullptr)
+    {
+      _allocator.deallocate(chunk);
+      return false;
+    }
+
+    _chunks.push_back(chunk);
+    _carve_begin = static_cast<std::byte *>(place);
+    _carve_end = _carve_begin + space / slot_size * slot_size;
+    return true;
+  }
+};
+
+} // namespace ac
+
+#endif // OBJECT_POOL_HPP
@@ -0,0 +1,561 @@
+#ifndef PERSISTENT_CHUNK_POOL_HPP
+#define PERSISTENT_CHUNK_POOL_HPP
+
+#include "ac_concepts.hpp"
+#include "chunk_list_wrapper.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <new>
+#include <span>
+#include <vector>
+#include <cassert>
+
+namespace ac
+{
+
+// How persistent_chunk_pool got the segment
+enum class pool_attach
+{
+  // The segment was empty or incompatible, everything is free
+  formatted,
+  // The previous owner closed the pool, its state is taken as is
+  reattached,
+  // The previous owner died, stored lists were verified
+  // and the free list was rebuilt
+  recovered
+};
+
+namespace detail
+{
+
+inline uint64_t fnv1a(std::initializer_list<uint64_t> values) noexcept
+{
+  uint64_t hash = 0xcbf29ce484222325;
+  for (uint64_t it : values)
+  {
+    for (int i = 0; i < 8; ++i)
+    {
+      hash ^= (it >> (i * 8)) & 0xff;
+      hash *= 0x100000001b3;
+    }
+  }
+  return hash;
+}
+
+// Lives at the beginning of the segment, only offsets are stored
+struct persistent_pool_header
+{
+  static constexpr uint64_t magic_value = 0x316c6f6f702d6361; // "ac-pool1"
+  // Bump on any change of the layout, older segments are formatted again
+  static constexpr uint32_t layout_version = 1;
+
+  enum : uint32_t { closed = 1, open = 2 };
+
+  uint64_t magic;
+  uint32_t version;
+  std::atomic<uint32_t> state;
+  // Geometry, covered by the checksum
+  uint64_t segment_size;
+  uint64_t chunk_size;
+  uint64_t chunks_count;
+  uint64_t lists_count;
+  uint64_t lists_offset;
+  uint64_t links_offset;
+  uint64_t owners_offset;
+  uint64_t data_offset;
+  uint64_t checksum;
+  // Allocation state, trusted only if the pool was closed
+  uint64_t generation;
+  std::atomic<uint64_t> high_water;
+  uint64_t remain;
+  // Allocated chunks that aren't stored in any list
+  uint64_t loose;
+  uint32_t free_head;
+};
+
+// Stored list: chain of chunks linked by ids and position of the data
+struct persistent_list_record
+{
+  // Odd while the record is being written
+  std::atomic<uint64_t> seq;
+  uint64_t head;
+  uint64_t size;
+  uint32_t first;
+  uint32_t chunks_count;
+  uint64_t checksum;
+};
+
+} // namespace detail
+
+// Chunk allocator whose whole state lives in a memory segment that outlives
+// the process (SysV, POSIX or memfd segment kept by another process), so
+// a restarted process gets its data back without reading it again.
+// store() parks the data of a persistent_chunk_list in a numbered slot.
+// load() takes it back. Both are O(chunks of the list).
+//
+// A process that closes the pool without loose chunks (allocated, but
+// not stored) leaves it `closed`, and the next one attaches in O(1).
+// Otherwise the pool is recovered in O(metadata): every stored list is
+// checked (record checksum, torn writes, chunk ownership, chain length),
+// broken lists are dropped, the free list is rebuilt from the chunk owner
+// table and loose chunks are freed. Data of chunks isn't checked.
+// An incompatible segment (other magic, version, geometry) is formatted.
+//
+// The pool MUST be used by one process at a time and isn't thread-safe,
+// wrap it in sync_chunk_allocator if threads share it.
+
+class persistent_chunk_pool
+{
+public:
+  using value_type = std::byte;
+  using chunk_type = std::span<value_type>;
+
+  static_assert(std::atomic<uint32_t>::is_always_lock_free
+                && std::atomic<uint64_t>::is_always_lock_free,
+                "Atomics MUST be lock-free to be kept in a segment");
+
+  // Chunk owners are list ids shifted by two in uint32_t
+  static constexpr size_t max_lists_count = std::numeric_limits<uint32_t>::max() - 2;
+
+public:
+  persistent_chunk_pool(void * base, size_t segment_size, size_t chunk_size, size_t lists_count) :
+    _base{static_cast<value_type *>(base)},
+    _header{static_cast<detail::persistent_pool_header *>(base)}
+  {
+    assert(reinterpret_cast<uintptr_t>(base) % data_align == 0 && "Segment MUST be aligned");
+    assert(lists_count <= max_lists_count && "Too many lists to index");
+
+    const bool formatted = compatible(segment_size, chunk_size, lists_count) == false;
+    if (formatted)
+      format(segment_size, chunk_size, lists_count);
+    map_layout();
+
+    if (formatted)
+    {
+      _status = pool_attach::formatted;
+    }
+    else if (_header->state.load(std::memory_order_acquire) == detail::persistent_pool_header::closed)
+    {
+      _status = pool_attach::reattached;
+    }
+    else
+    {
+      recover();
+      _status = pool_attach::recovered;
+    }
+
+    ++_header->generation;
+    _header->state.store(detail::persistent_pool_header::open, std::memory_order_release);
+  }
+
+  // Segment MUST be attached
+  template<IsSharedMemorySegment Segment>
+  persistent_chunk_pool(Segment & segment, size_t chunk_size, size_t lists_count) :
+    persistent_chunk_pool(segment.get_base_pointer().value(), segment.size(), chunk_size, lists_count)
+  {}
+
+  // Loose chunks would be lost, so the pool is closed only without them
+  ~persistent_chunk_pool()
+  {
+    if (_header->loose == 0)
+      _header->state.store(detail::persistent_pool_header::closed, std::memory_order_release);
+  }
+
+  persistent_chunk_pool(const persistent_chunk_pool &) = delete;
+  persistent_chunk_pool & operator =(const persistent_chunk_pool &) = delete;
+
+  [[nodiscard]]
+  chunk_type allocate()
+  {
+    auto & header = *_header;
+    chunk_id_type chunk_id = header.free_head;
+    if (chunk_id != npos)
+    {
+      header.free_head = _links[chunk_id];
+    }
+    else
+    {
+      uint64_t high_water = header.high_water.load(std::memory_order_relaxed);
+      if (high_water == _chunks_count)
+        return {};
+      chunk_id = static_cast<chunk_id_type>(high_water);
+      // Recovery reads owners below the high-water mark only
+      _owners[chunk_id] = owner_loose;
+      header.high_water.store(high_water + 1, std::memory_order_release);
+    }
+
+    _owners[chunk_id] = owner_loose;
+    --header.remain;
+    ++header.loose;
+    return chunk_at(chunk_id);
+  }
+
+  // Chunks of stored lists and free ones are ignored
+  void deallocate(chunk_type chunk)
+  {
+    chunk_id_type chunk_id = id_of(chunk);
+    if (chunk_id == npos || _owners[chunk_id] != owner_loose)
+      return;
+
+    auto & header = *_header;
+    _owners[chunk_id] = owner_free;
+    _links[chunk_id] = header.free_head;
+    header.free_head = chunk_id;
+    ++header.remain;
+    --header.loose;
+  }
+
+  // Moves data of `list` to the slot `list_id`, the list becomes empty.
+  // Fails if the slot is taken or the chunks aren't allocated by this pool
+  template<class List>
+  [[nodiscard]]
+  bool store(size_t list_id, List & list)
+  {
+    if (list_id >= _lists_count || stored(list_id))
+      return false;
+
+    const size_t count = list.chunks_count();
+    for (size_t i = 0; i < count; ++i)
+    {
+      chunk_id_type chunk_id = id_of(list.chunk_at(i));
+      if (chunk_id == npos || _owners[chunk_id] != owner_loose)
+        return false;
+    }
+    if (count == 0)
+      return true;
+
+    auto & record = _lists[list_id];
+    begin_write(record);
+    chunk_id_type next = npos;
+    for (size_t i = count; i-- > 0;)
+    {
+      chunk_id_type chunk_id = id_of(list.chunk_at(i));
+      _links[chunk_id] = next;
+      _owners[chunk_id] = owner_of(list_id);
+      next = chunk_id;
+    }
+    record.first = next;
+    record.chunks_count = static_cast<uint32_t>(count);
+    record.head = list.head_offset();
+    record.size = list.size();
+    end_write(record);
+
+    _header->loose -= count;
+    list.release();
+    return true;
+  }
+
+  // Moves data stored in the slot `list_id` to `list`, its own data is
+  // cleared. Fails if the slot is empty or the stored list is broken,
+  // the broken one is dropped
+  template<class List>
+  [[nodiscard]]
+  bool load(size_t list_id, List & list)
+  {
+    if (list_id >= _lists_count || stored(list_id) == false)
+      return false;
+    if (verify(list_id) == false)
+    {
+      drop(list_id);
+      return false;
+    }
+
+    auto & record = _lists[list_id];
+    std::vector<chunk_type> chunks;
+    chunks.reserve(record.chunks_count);
+    for (chunk_id_type it = record.first; it != npos; it = _links[it])
+      chunks.push_back(chunk_at(it));
+    const size_t head = record.head;
+    const size_t size = record.size;
+
+    // Chunks owned by no valid record are freed by recovery
+    reset(record);
+    for (auto & it : chunks)
+      _owners[id_of(it)] = owner_loose;
+    _header->loose += chunks.size();
+
+    list.adopt(chunks, head, size);
+    return true;
+  }
+
+  // Frees chunks of the list stored in the slot `list_id`
+  void drop(size_t list_id)
+  {
+    if (list_id >= _lists_count || stored(list_id) == false)
+      return;
+
+    auto & record = _lists[list_id];
+    const bool valid = verify(list_id);
+    const chunk_id_type first = record.first;
+    reset(record);
+
+    auto release = [this](chunk_id_type chunk_id)
+    {
+      _owners[chunk_id] = owner_loose;
+      ++_header->loose;
+      deallocate(chunk_at(chunk_id));
+    };
+
+    if (valid)
+    {
+      for (chunk_id_type it = first, next = npos; it != npos; it = next)
+      {
+        next = _links[it];
+        release(it);
+      }
+      return;
+    }
+
+    // The chain can't be trusted, so owners are looked through
+    const size_t high_water = _header->high_water.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < high_water; ++i)
+    {
+      if (_owners[i] == owner_of(list_id))
+        release(static_cast<chunk_id_type>(i));
+    }
+  }
+
+  bool stored(size_t list_id) const noexcept
+  {
+    return list_id < _lists_count && _lists[list_id].chunks_count != 0;
+  }
+
+  // Bytes of the list stored in the slot `list_id`
+  size_t stored_size(size_t list_id) const noexcept
+  {
+    return stored(list_id) ? _lists[list_id].size : 0;
+  }
+
+  size_t size()   const noexcept { return _chunks_count; }
+  size_t remain() const noexcept { return _header->remain; }
+  size_t in_use() const noexcept { return size() - remain(); }
+
+  size_t chunk_size() const noexcept { return _chunk_size; }
+  size_t lists_count() const noexcept { return _lists_count; }
+
+  pool_attach attach_status() const noexcept { return _status; }
+  // Count of attaches since the segment was formatted
+  uint64_t generation() const noexcept { return _header->generation; }
+
+private:
+  using header_type = detail::persistent_pool_header;
+  using record_type = detail::persistent_list_record;
+  using chunk_id_type = uint32_t;
+
+  static constexpr chunk_id_type npos = std::numeric_limits<chunk_id_type>::max();
+  static constexpr size_t data_align = 64;
+
+  // Zero-filled owners mean free chunks
+  static constexpr uint32_t owner_free = 0;
+  static constexpr uint32_t owner_loose = 1;
+
+  static constexpr uint32_t owner_of(size_t list_id) noexcept
+  {
+    return static_cast<uint32_t>(list_id + 2);
+  }
+
+  static constexpr size_t round_up(size_t len, size_t align) noexcept
+  {
+    return (len + align - 1) / align * align;
+  }
+
+  value_type * _base;
+  header_type * _header;
+  record_type * _lists{nullptr};
+  chunk_id_type * _links{nullptr};
+  uint32_t * _owners{nullptr};
+  value_type * _data{nullptr};
+  size_t _chunk_size{0};
+  size_t _chunks_count{0};
+  size_t _lists_count{0};
+  pool_attach _status{pool_attach::formatted};
+
+  chunk_type chunk_at(size_t chunk_id) const noexcept
+  {
+    return chunk_type{_data + _chunk_size * chunk_id, _chunk_size};
+  }
+
+  // Returns npos for chunks that were never handed out
+  chunk_id_type id_of(chunk_type chunk) const noexcept
+  {
+    size_t chunk_place = chunk.data() - _data;
+    if (chunk.size() != _chunk_size || chunk_place % _chunk_size != 0)
+      return npos;
+    size_t chunk_id = chunk_place / _chunk_size;
+    if (chunk_id >= _header->high_water.load(std::memory_order_relaxed))
+      return npos;
+    return static_cast<chunk_id_type>(chunk_id);
+  }
+
+  static uint64_t geometry_checksum(const header_type & header) noexcept
+  {
+    return detail::fnv1a({header.magic, header.version, header.segment_size,
+                          header.chunk_size, header.chunks_count, header.lists_count,
+                          header.lists_offset, header.links_offset,
+                          header.owners_offset, header.data_offset});
+  }
+
+  static uint64_t record_checksum(const record_type & record) noexcept
+  {
+    return detail::fnv1a({record.head, record.size, record.first, record.chunks_count});
+  }
+
+  bool compatible(size_t segment_size, size_t chunk_size, size_t lists_count) const noexcept
+  {
+    const auto & header = *_header;
+    const uint32_t state = header.state.load(std::memory_order_acquire);
+    return header.magic == header_type::magic_value
+      && header.version == header_type::layout_version
+      && (state == header_type::closed || state == header_type::open)
+      && header.checksum == geometry_checksum(header)
+      && header.segment_size <= segment_size
+      && header.chunk_size == chunk_size
+      && header.lists_count == lists_count
+      && header.data_offset + header.chunks_count * header.chunk_size <= header.segment_size;
+  }
+
+  void map_layout() noexcept
+  {
+    const auto & header = *_header;
+    _lists = reinterpret_cast<record_type *>(_base + header.lists_offset);
+    _links = reinterpret_cast<chunk_id_type *>(_base + header.links_offset);
+    _owners = reinterpret_cast<uint32_t *>(_base + header.owners_offset);
+    _data = _base + header.data_offset;
+    _chunk_size = header.chunk_size;
+    _chunks_count = header.chunks_count;
+    _lists_count = header.lists_count;
+  }
+
+  // Chunks above the high-water mark are never touched, so it's O(lists).
+  // The magic is written last, a crash before that leaves the segment
+  // incompatible and it's formatted again
+  void format(size_t segment_size, size_t chunk_size, size_t lists_count)
+  {
+    assert(chunk_size > 0 && "Chunk size MUST be positive");
+    const size_t lists_offset = round_up(sizeof(header_type), data_align);
+    const size_t links_offset = round_up(lists_offset + lists_count * sizeof(record_type), data_align);
+    const size_t overhead = links_offset + data_align;
+    size_t chunks_count = segment_size > overhead
+      ? (segment_size - overhead) / (chunk_size + sizeof(chunk_id_type) + sizeof(uint32_t))
+      : 0;
+    if (chunks_count >= npos)
+      chunks_count = npos - 1;
+    const size_t owners_offset = links_offset + chunks_count * sizeof(chunk_id_type);
+    const size_t data_offset = round_up(owners_offset + chunks_count * sizeof(uint32_t), data_align);
+    assert(chunks_count > 0 && "Segment is too small for a chunk");
+
+    auto * header = new (_base) header_type{};
+    auto * lists = reinterpret_cast<record_type *>(_base + lists_offset);
+    for (size_t i = 0; i < lists_count; ++i)
+      reset(*new (lists + i) record_type{});
+
+    header->version = header_type::layout_version;
+    header->segment_size = segment_size;
+    header->chunk_size = chunk_size;
+    header->chunks_count = chunks_count;
+    header->lists_count = lists_count;
+    header->lists_offset = lists_offset;
+    header->links_offset = links_offset;
+    header->owners_offset = owners_offset;
+    header->data_offset = data_offset;
+    header->generation = 0;
+    header->high_water.store(0, std::memory_order_relaxed);
+    header->remain = chunks_count;
+    header->loose = 0;
+    header->free_head = npos;
+    header->magic = header_type::magic_value;
+    header->checksum = geometry_checksum(*header);
+    header->state.store(header_type::open, std::memory_order_release);
+  }
+
+  // Writes between begin_write() and end_write() are visible to recovery
+  // only if all of them are done
+  static void begin_write(record_type & record) noexcept
+  {
+    record.seq.store(record.seq.load(std::memory_order_relaxed) | 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  static void end_write(record_type & record) noexcept
+  {
+    record.checksum = record_checksum(record);
+    record.seq.store(record.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  static void reset(record_type & record) noexcept
+  {
+    begin_write(record);
+    record.head = 0;
+    record.size = 0;
+    record.first = npos;
+    record.chunks_count = 0;
+    end_write(record);
+  }
+
+  // Checks that the record is complete and its chain has exactly the
+  // recorded count of chunks owned by the list, which also rules out cycles
+  bool verify(size_t list_id) const noexcept
+  {
+    const auto & record = _lists[list_id];
+    if ((record.seq.load(std::memory_order_acquire) & 1) != 0
+        || record.checksum != record_checksum(record))
+      return false;
+
+    const size_t high_water = _header->high_water.load(std::memory_order_relaxed);
+    if (record.chunks_count > high_water)
+      return false;
+    if (record.head + record.size > size_t{record.chunks_count} * _chunk_size)
+      return false;
+
+    chunk_id_type it = record.first;
+    for (size_t i = 0; i < record.chunks_count; ++i)
+    {
+      if (it >= high_water || _owners[it] != owner_of(list_id))
+        return false;
+      it = _links[it];
+    }
+    return it == npos;
+  }
+
+  // Only owners of chunks and verified records are trusted, the rest of
+  // the allocation state is rebuilt from them
+  void recover()
+  {
+    const size_t high_water = _header->high_water.load(std::memory_order_relaxed);
+    std::vector<bool> stored_chunks(high_water);
+    for (size_t i = 0; i < _lists_count; ++i)
+    {
+      auto & record = _lists[i];
+      if (verify(i) == false)
+      {
+        reset(record);
+        continue;
+      }
+      for (chunk_id_type it = record.first; it != npos; it = _links[it])
+        stored_chunks[it] = true;
+    }
+
+    auto & header = *_header;
+    header.free_head = npos;
+    header.remain = _chunks_count - high_water;
+    header.loose = 0;
+    for (size_t i = high_water; i-- > 0;)
+    {
+      if (stored_chunks[i])
+        continue;
+      _owners[i] = owner_free;
+      _links[i] = header.free_head;
+      header.free_head = static_cast<chunk_id_type>(i);
+      ++header.remain;
+    }
+  }
+};
+
+using persistent_chunk_list = chunk_list_wrapper<persistent_chunk_pool>;
+
+} // namespace ac
+
+#endif // PERSISTENT_CHUNK_POOL_HPP
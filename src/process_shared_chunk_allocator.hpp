@@ -0,0 +1,248 @@
+#ifndef PROCESS_SHARED_CHUNK_ALLOCATOR_HPP
+#define PROCESS_SHARED_CHUNK_ALLOCATOR_HPP
+
+#include "ac_concepts.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <span>
+#include <thread>
+#include <cassert>
+
+namespace ac
+{
+
+// Process-independent reference to a chunk: offset from the segment base
+struct shared_chunk_handle
+{
+  // Zero points to the segment header, so it's never a chunk
+  uint64_t offset{0};
+
+  bool empty() const noexcept { return offset == 0; }
+};
+
+namespace detail
+{
+
+// Lives at the beginning of the segment. Only offsets are stored,
+// every process maps the segment at its own address
+struct process_shared_header
+{
+  static constexpr uint64_t magic_value = 0x31306d68732d6361; // "ac-shm01"
+
+  enum : uint32_t { empty = 0, formatting = 1, ready = 2 };
+
+  std::atomic<uint32_t> state;
+  uint64_t magic;
+  uint64_t segment_size;
+  uint64_t chunk_size;
+  uint64_t chunks_count;
+  uint64_t links_offset;
+  uint64_t data_offset;
+  alignas(64) std::atomic<uint64_t> head;
+  alignas(64) std::atomic<uint64_t> remain;
+};
+
+} // namespace detail
+
+// Lock-free chunk allocator shared by processes that map the same memory
+// segment (e.g. IsSharedMemorySegment). The header, the free list and
+// chunks are inside the segment, the free list is the same tagged Treiber
+// stack as in lockfree_chunk_allocator, links are chunk ids, not pointers.
+// Atomics are lock-free, so they work across processes.
+//
+// The first process formats the segment, others wait for it and take chunk
+// size from the header. The segment MUST be zero-filled before the first
+// use (new SysV and POSIX segments are). Chunks are passed between
+// processes as shared_chunk_handle, each process translates them with its
+// own base pointer. A process that crashes holding chunks leaks them.
+
+class process_shared_chunk_allocator
+{
+public:
+  using value_type = std::byte;
+  using chunk_type = std::span<value_type>;
+
+  static_assert(std::atomic<uint32_t>::is_always_lock_free
+                && std::atomic<uint64_t>::is_always_lock_free,
+                "Atomics MUST be lock-free to be shared by processes");
+
+public:
+  process_shared_chunk_allocator(void * base, size_t segment_size, size_t chunk_size) :
+    _base{static_cast<value_type *>(base)},
+    _header{static_cast<detail::process_shared_header *>(base)}
+  {
+    assert(reinterpret_cast<uintptr_t>(base) % alignof(detail::process_shared_header) == 0
+           && "Segment MUST be aligned for the header");
+
+    uint32_t state = detail::process_shared_header::empty;
+    if (_header->state.compare_exchange_strong(state, detail::process_shared_header::formatting,
+                                               std::memory_order_acquire))
+    {
+      format(segment_size, chunk_size);
+    }
+    else
+    {
+      while (_header->state.load(std::memory_order_acquire) != detail::process_shared_header::ready)
+        std::this_thread::yield();
+    }
+
+    assert(_header->magic == detail::process_shared_header::magic_value && "Segment is corrupted");
+    assert(_header->chunk_size == chunk_size && "Segment is formatted for other chunk size");
+    assert(_header->segment_size <= segment_size && "Segment is smaller than formatted");
+    _chunk_size = _header->chunk_size;
+    _chunks_count = _header->chunks_count;
+    _next = reinterpret_cast<std::atomic<chunk_id_type> *>(_base + _header->links_offset);
+    _data = _base + _header->data_offset;
+  }
+
+  // Segment MUST be attached
+  template<IsSharedMemorySegment Segment>
+  process_shared_chunk_allocator(Segment & segment, size_t chunk_size) :
+    process_shared_chunk_allocator(segment.get_base_pointer().value(), segment.size(), chunk_size)
+  {}
+
+  [[nodiscard]]
+  chunk_type allocate()
+  {
+    uint64_t head = _header->head.load(std::memory_order_acquire);
+    while (true)
+    {
+      chunk_id_type chunk_id = head_id(head);
+      if (chunk_id == npos)
+        return {};
+
+      // Stale value is fine here, the tag makes the CAS fail in that case
+      chunk_id_type next = _next[chunk_id].load(std::memory_order_relaxed);
+      if (_header->head.compare_exchange_weak(head, make_head(next, head_tag(head) + 1),
+                                              std::memory_order_acquire,
+                                              std::memory_order_acquire))
+      {
+        _header->remain.fetch_sub(1, std::memory_order_relaxed);
+        return chunk_at(chunk_id);
+      }
+    }
+  }
+
+  void deallocate(chunk_type chunk)
+  {
+    size_t chunk_place = chunk.data() - _data;
+    if (chunk_place % _chunk_size != 0)
+      return;
+    size_t chunk_id = chunk_place / _chunk_size;
+    if (chunk_id >= _chunks_count)
+      return;
+
+    // Before the chunk may be popped and counted by another process
+    _header->remain.fetch_add(1, std::memory_order_relaxed);
+    uint64_t head = _header->head.load(std::memory_order_relaxed);
+    do
+    {
+      _next[chunk_id].store(head_id(head), std::memory_order_relaxed);
+    }
+    while (!_header->head.compare_exchange_weak(head,
+                                                make_head(static_cast<chunk_id_type>(chunk_id), head_tag(head)),
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed));
+  }
+
+  void deallocate(shared_chunk_handle handle)
+  {
+    deallocate(from_handle(handle));
+  }
+
+  shared_chunk_handle to_handle(chunk_type chunk) const noexcept
+  {
+    if (chunk.empty())
+      return {};
+    return shared_chunk_handle{static_cast<uint64_t>(chunk.data() - _base)};
+  }
+
+  // Handle MUST come from an allocator over the same segment
+  chunk_type from_handle(shared_chunk_handle handle) const noexcept
+  {
+    if (handle.empty())
+      return {};
+    return chunk_type{_base + handle.offset, _chunk_size};
+  }
+
+  size_t size()   const noexcept { return _chunks_count; }
+  // Freed chunks are counted before they're pushed, so it's clamped
+  size_t remain() const noexcept
+  {
+    return std::min<size_t>(_header->remain.load(std::memory_order_relaxed), _chunks_count);
+  }
+  size_t in_use() const noexcept { return size() - remain(); }
+
+  size_t chunk_size() const noexcept { return _chunk_size; }
+
+private:
+  using chunk_id_type = uint32_t;
+  static constexpr chunk_id_type npos = std::numeric_limits<chunk_id_type>::max();
+  static constexpr size_t data_align = 64;
+
+  static constexpr uint64_t make_head(chunk_id_type id, uint32_t tag) noexcept
+  {
+    return (uint64_t{tag} << 32) | id;
+  }
+  static constexpr chunk_id_type head_id(uint64_t head) noexcept
+  {
+    return static_cast<chunk_id_type>(head);
+  }
+  static constexpr uint32_t head_tag(uint64_t head) noexcept
+  {
+    return static_cast<uint32_t>(head >> 32);
+  }
+
+  static constexpr size_t round_up(size_t len, size_t align) noexcept
+  {
+    return (len + align - 1) / align * align;
+  }
+
+  value_type * _base;
+  detail::process_shared_header * _header;
+  std::atomic<chunk_id_type> * _next{nullptr};
+  value_type * _data{nullptr};
+  size_t _chunk_size{0};
+  size_t _chunks_count{0};
+
+  chunk_type chunk_at(size_t chunk_id) const noexcept
+  {
+    return chunk_type{_data + _chunk_size * chunk_id, _chunk_size};
+  }
+
+  // Runs in the process that won the segment, others wait for `ready`
+  void format(size_t segment_size, size_t chunk_size)
+  {
+    const size_t links_offset = sizeof(detail::process_shared_header);
+    const size_t overhead = round_up(links_offset, data_align) + data_align;
+    size_t chunks_count = segment_size > overhead
+      ? (segment_size - overhead) / (chunk_size + sizeof(chunk_id_type))
+      : 0;
+    if (chunks_count >= npos)
+      chunks_count = npos - 1;
+    const size_t data_offset = round_up(links_offset + chunks_count * sizeof(chunk_id_type), data_align);
+    assert(chunks_count > 0 && "Segment is too small for a chunk");
+
+    auto * links = reinterpret_cast<std::atomic<chunk_id_type> *>(_base + links_offset);
+    for (size_t i = 0; i < chunks_count; ++i)
+      new (links + i) std::atomic<chunk_id_type>{i + 1 < chunks_count ? static_cast<chunk_id_type>(i + 1) : npos};
+
+    _header->magic = detail::process_shared_header::magic_value;
+    _header->segment_size = segment_size;
+    _header->chunk_size = chunk_size;
+    _header->chunks_count = chunks_count;
+    _header->links_offset = links_offset;
+    _header->data_offset = data_offset;
+    _header->head.store(make_head(chunks_count == 0 ? npos : 0, 0), std::memory_order_relaxed);
+    _header->remain.store(chunks_count, std::memory_order_relaxed);
+    _header->state.store(detail::process_shared_header::ready, std::memory_order_release);
+  }
+};
+
+} // namespace ac
+
+#endif // PROCESS_SHARED_CHUNK_ALLOCATOR_HPP
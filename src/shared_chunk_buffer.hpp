@@ -0,0 +1,263 @@
+#ifndef SHARED_CHUNK_BUFFER_HPP
+#define SHARED_CHUNK_BUFFER_HPP
+
+#include "ac_concepts.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace ac
+{
+
+namespace detail
+{
+
+// Lives at the beginning of every chunk owned by shared_chunk_buffer,
+// the rest of the chunk is payload
+template<class Chunk>
+struct shared_chunk_header
+{
+  Chunk chunk;
+  std::atomic<uint32_t> refs;
+};
+
+} // namespace detail
+
+// Chain of reference-counted chunks, copies share the chunks instead of
+// the data (like folly::IOBuf). A chunk goes back to the allocator when the
+// last buffer referencing it releases it. slice() makes a buffer with
+// a sub-range of the data, also without copying.
+//
+// One buffer object MUST NOT be used by several threads at once, but copies
+// may be used and destroyed on any thread, so the allocator MUST be
+// thread-safe in that case. Data is appended in place only if nobody else
+// shares the last chunk, otherwise a new chunk is taken.
+
+template<IsChunkAllocator Allocator>
+class shared_chunk_buffer
+{
+public:
+  using allocator_type = Allocator;
+  using value_type = typename allocator_type::value_type;
+  using chunk_type = typename allocator_type::chunk_type;
+  using segment_type = std::span<const value_type>;
+
+  explicit
+    shared_chunk_buffer(allocator_type & allocator) :
+    _allocator(&allocator),
+    _size(0)
+  {}
+
+  shared_chunk_buffer(const shared_chunk_buffer & other) :
+    _allocator(other._allocator),
+    _segments(other._segments),
+    _size(other._size)
+  {
+    for (auto & it : _segments)
+      it.node->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  shared_chunk_buffer(shared_chunk_buffer && other) noexcept :
+    _allocator(other._allocator),
+    _segments(std::move(other._segments)),
+    _size(std::exchange(other._size, 0))
+  {
+    other._segments.clear();
+  }
+
+  shared_chunk_buffer & operator =(const shared_chunk_buffer & other)
+  {
+    if (this != &other)
+      *this = shared_chunk_buffer{other};
+    return *this;
+  }
+
+  shared_chunk_buffer & operator =(shared_chunk_buffer && other) noexcept
+  {
+    if (this != &other)
+    {
+      clear();
+      _allocator = other._allocator;
+      _segments = std::move(other._segments);
+      _size = std::exchange(other._size, 0);
+      other._segments.clear();
+    }
+    return *this;
+  }
+
+  ~shared_chunk_buffer()
+  {
+    clear();
+  }
+
+  [[nodiscard]]
+  size_t write(const value_type * buf, size_t len)
+  {
+    const size_t orig_len = len;
+    if (_segments.empty() == false)
+      write_to_last(buf, len);
+
+    while (len > 0)
+    {
+      if (allocate_next() == false)
+        break;
+      write_to_last(buf, len);
+    }
+    return orig_len - len;
+  }
+
+  // Returns buffer sharing range [offset, offset + len) of the data
+  [[nodiscard]]
+  shared_chunk_buffer slice(size_t offset, size_t len) const
+  {
+    shared_chunk_buffer ret{*_allocator};
+    if (offset >= _size)
+      return ret;
+    len = std::min(len, _size - offset);
+
+    for (auto it = _segments.begin(); it != _segments.end() && len > 0; ++it)
+    {
+      if (offset >= it->len)
+      {
+        offset -= it->len;
+        continue;
+      }
+
+      segment piece{it->node, it->data + offset, std::min(it->len - offset, len)};
+      piece.node->refs.fetch_add(1, std::memory_order_relaxed);
+      ret._segments.push_back(piece);
+      ret._size += piece.len;
+      len -= piece.len;
+      offset = 0;
+    }
+    return ret;
+  }
+
+  [[nodiscard]]
+  size_t read(size_t offset, const value_type *& buf, size_t len) const
+  {
+    for (auto & it : _segments)
+    {
+      if (offset < it.len)
+      {
+        buf = it.data + offset;
+        return std::min(it.len - offset, len);
+      }
+      offset -= it.len;
+    }
+    return 0;
+  }
+
+  [[nodiscard]]
+  size_t read_copy(size_t offset, value_type * buf, size_t len) const
+  {
+    const size_t orig_len = len;
+    const value_type * read_buf = nullptr;
+
+    size_t rem = 0;
+    while (len > 0)
+    {
+      rem = read(offset, read_buf, len);
+      if (rem == 0)
+        break;
+
+      ::memcpy(buf, read_buf, rem);
+      buf += rem;
+      len -= rem;
+      offset += rem;
+    }
+    return orig_len - len;
+  }
+
+  // Fills `out` with contiguous pieces of the data, returns count of them
+  [[nodiscard]]
+  size_t segments(std::span<segment_type> out) const
+  {
+    size_t count = std::min(out.size(), _segments.size());
+    for (size_t i = 0; i < count; ++i)
+      out[i] = segment_type{_segments[i].data, _segments[i].len};
+    return count;
+  }
+
+  void clear()
+  {
+    for (auto & it : _segments)
+      release(it.node);
+    _segments.clear();
+    _size = 0;
+  }
+
+  size_t size() const noexcept { return _size; }
+  size_t chunks_count() const noexcept { return _segments.size(); }
+
+private:
+  using header = detail::shared_chunk_header<chunk_type>;
+
+  struct segment
+  {
+    header * node;
+    value_type * data;
+    size_t len;
+  };
+
+  allocator_type * _allocator;
+  std::vector<segment> _segments;
+  size_t _size;
+
+  void release(header * node)
+  {
+    if (node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+      return;
+    chunk_type chunk = node->chunk;
+    node->~header();
+    _allocator->deallocate(chunk);
+  }
+
+  void write_to_last(const value_type *& buf, size_t & len)
+  {
+    auto & last = _segments.back();
+    // Bytes after the segment may be referenced by other buffers
+    if (last.node->refs.load(std::memory_order_acquire) != 1)
+      return;
+
+    value_type * end = last.data + last.len;
+    value_type * chunk_end = last.node->chunk.data() + last.node->chunk.size();
+    size_t write_size = std::min<size_t>(chunk_end - end, len);
+    ::memcpy(end, buf, write_size);
+    last.len += write_size;
+    _size += write_size;
+    buf += write_size;
+    len -= write_size;
+  }
+
+  bool allocate_next()
+  {
+    auto chunk = _allocator->allocate();
+    if (chunk.empty())
+      return false;
+
+    void * place = chunk.data();
+    size_t space = chunk.size();
+    if (std::align(alignof(header), sizeof(header), place, space) == nullptr
+        || space <= sizeof(header))
+    {
+      _allocator->deallocate(chunk);
+      return false;
+    }
+
+    auto * node = new (place) header{chunk, 1};
+    _segments.push_back(segment{node, reinterpret_cast<value_type *>(node + 1), 0});
+    return true;
+  }
+};
+
+} // namespace ac
+
+#endif // SHARED_CHUNK_BUFFER_HPP
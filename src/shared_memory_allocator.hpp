@@ -23,13 +23,13 @@ public:
   ~shared_memory_allocator()
   {
     if (attached())
-      detach();
+      (void)detach();
   }
 
   [[nodiscard]]
   bool attach() noexcept
   {
-    if (_segment_id == false)
+    if (_segment_id.has_value() == false)
       return false;
 
     int segment_id = *_segment_id;
@@ -44,7 +44,7 @@ public:
   [[nodiscard]]
   bool detach() noexcept
   {
-    if (_base_address == false)
+    if (_base_address.has_value() == false)
       return false;
     int res = shmdt(*_base_address);
     if (res == 0)
@@ -69,7 +69,7 @@ public:
     // If already exist, try to attach
     if (errno == EEXIST)
     {
-      segment_id = shmget(_ket, 0, 0);
+      segment_id = shmget(_key, 0, 0);
       // Attach failed :(
       if (segment_id == -1)
         return false;
@@ -92,12 +92,26 @@ public:
     return attach() || (allocate() && attach());
   }
 
+  // Marks the segment to be destroyed after the last process detaches
+  [[nodiscard]]
+  bool remove() noexcept
+  {
+    if (_segment_id.has_value() == false)
+      return false;
+    return shmctl(*_segment_id, IPC_RMID, nullptr) == 0;
+  }
+
   [[nodiscard]]
   std::optional<void *> get_base_pointer() const noexcept
   {
     return _base_address;
   }
 
+  size_t size() const noexcept
+  {
+    return _size;
+  }
+
 private:
   key_t _key;
   size_t _size;
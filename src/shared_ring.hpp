@@ -0,0 +1,487 @@
+#ifndef SHARED_RING_HPP
+#define SHARED_RING_HPP
+
+#include "ac_concepts.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <span>
+#include <thread>
+#include <cassert>
+
+#ifdef __linux__
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ac
+{
+
+namespace detail
+{
+
+// Lives at the beginning of the ring segment, positions are monotonic
+// byte counters, their remainder by capacity is the offset in the data
+struct shared_ring_header
+{
+  static constexpr uint64_t magic_value = 0x31676e722d6361; // "ac-rng1"
+
+  enum : uint32_t { empty = 0, formatting = 1, ready = 2 };
+
+  std::atomic<uint32_t> state;
+  uint32_t multi_producer;
+  uint64_t magic;
+  uint64_t capacity;
+  uint64_t data_offset;
+  // Space claimed by producers, only multi-producer rings use it
+  alignas(64) std::atomic<uint64_t> reserve;
+  // Space published to the consumer
+  alignas(64) std::atomic<uint64_t> tail;
+  alignas(64) std::atomic<uint64_t> head;
+  // Futex words, bumped only when somebody waits
+  alignas(64) std::atomic<uint32_t> data_seq;
+  std::atomic<uint32_t> consumer_waiting;
+  alignas(64) std::atomic<uint32_t> space_seq;
+  std::atomic<uint32_t> producers_waiting;
+};
+
+// Precedes every message, messages are padded to the record alignment
+struct shared_ring_record
+{
+  static constexpr uint32_t skip = 1;
+
+  uint32_t len;
+  uint32_t flags;
+  uint64_t reserved;
+};
+
+inline constexpr size_t shared_ring_align = sizeof(shared_ring_record);
+
+constexpr size_t shared_ring_record_size(size_t len) noexcept
+{
+  return sizeof(shared_ring_record) + (len + shared_ring_align - 1) / shared_ring_align * shared_ring_align;
+}
+
+#ifdef __linux__
+// Futexes aren't private, so they work across processes
+inline void futex_wait(std::atomic<uint32_t> & word, uint32_t expected,
+                       std::chrono::nanoseconds timeout) noexcept
+{
+  auto secs = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+  timespec ts{static_cast<time_t>(secs.count()), static_cast<long>((timeout - secs).count())};
+  ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+inline void futex_wake(std::atomic<uint32_t> & word, int count) noexcept
+{
+  ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, count, nullptr, nullptr, 0);
+}
+#endif // __linux__
+
+} // namespace detail
+
+// Message ring in memory shared by processes (e.g. shared_memory_allocator),
+// there are single-producer (spsc_ring) and multi-producer (mpsc_ring)
+// flavours, both with a single consumer. Head and tail are on separate
+// cache lines and every side caches the other's position, so it's read
+// only when the cached one says the ring is full or empty.
+//
+// Messages are written in place and published in batches: publish() of the
+// single producer and try_push_batch() make the whole batch visible with one
+// store. The consumer releases space once per consume() call. Producers of
+// mpsc_ring claim space with a CAS and publish in claim order, so a producer
+// waits for the ones that claimed before it.
+//
+// The first side formats the segment, the segment MUST be zero-filled before
+// that (new SysV and POSIX segments are). wait_readable()/wait_writable()
+// block on a futex (Linux only), it's touched only if somebody waits, so
+// non-blocking users pay nothing for it. Every process uses its own object.
+
+template<bool MultiProducer>
+class shared_ring
+{
+public:
+  using value_type = std::byte;
+
+  static_assert(std::atomic<uint32_t>::is_always_lock_free
+                && std::atomic<uint64_t>::is_always_lock_free,
+                "Atomics MUST be lock-free to be shared by processes");
+
+public:
+  shared_ring(void * base, size_t segment_size) :
+    _header{static_cast<detail::shared_ring_header *>(base)}
+  {
+    assert(reinterpret_cast<uintptr_t>(base) % alignof(detail::shared_ring_header) == 0
+           && "Segment MUST be aligned for the header");
+
+    uint32_t state = detail::shared_ring_header::empty;
+    if (_header->state.compare_exchange_strong(state, detail::shared_ring_header::formatting,
+                                               std::memory_order_acquire))
+    {
+      format(segment_size);
+    }
+    else
+    {
+      while (_header->state.load(std::memory_order_acquire) != detail::shared_ring_header::ready)
+        std::this_thread::yield();
+    }
+
+    assert(_header->magic == detail::shared_ring_header::magic_value && "Segment is corrupted");
+    assert(_header->multi_producer == MultiProducer && "Segment is formatted for other ring");
+    _data = static_cast<value_type *>(base) + _header->data_offset;
+    _capacity = _header->capacity;
+    _tail = _header->tail.load(std::memory_order_acquire);
+    _head = _header->head.load(std::memory_order_acquire);
+    _head_cache = _head;
+    _tail_cache = _tail;
+  }
+
+  // Segment MUST be attached
+  template<IsSharedMemorySegment Segment>
+  explicit
+    shared_ring(Segment & segment) :
+    shared_ring(segment.get_base_pointer().value(), segment.size())
+  {}
+
+  // Producer side
+
+  // Returns memory for a message of up to `len` bytes, it becomes
+  // a message after commit(). Empty span means the ring is full
+  [[nodiscard]]
+  std::span<value_type> prepare(size_t len) requires (!MultiProducer)
+  {
+    if (len > max_message_size())
+      return {};
+
+    const size_t need = claim_size(_tail, len);
+    if (has_space(_tail, need) == false)
+      return {};
+
+    if (need != detail::shared_ring_record_size(len))
+    {
+      write_skip(_tail);
+      _tail += _capacity - offset(_tail);
+    }
+    _prepared = len;
+    return {payload(_tail), len};
+  }
+
+  // Makes `len` bytes of the prepared memory a message,
+  // it's visible to the consumer after publish()
+  void commit(size_t len) requires (!MultiProducer)
+  {
+    assert(len <= _prepared && "Commit MUSTN'T exceed the prepared memory");
+    write_record(_tail, static_cast<uint32_t>(len));
+    _tail += detail::shared_ring_record_size(len);
+    _prepared = 0;
+  }
+
+  void publish() requires (!MultiProducer)
+  {
+    _header->tail.store(_tail, std::memory_order_release);
+    wake_consumer();
+  }
+
+  [[nodiscard]]
+  bool try_push(std::span<const value_type> message)
+  {
+    return try_push_batch(std::span<const std::span<const value_type>>{&message, 1});
+  }
+
+  // Either all messages are published at once or none of them
+  [[nodiscard]]
+  bool try_push_batch(std::span<const std::span<const value_type>> messages)
+  {
+    if constexpr (MultiProducer)
+    {
+      uint64_t pos = _header->reserve.load(std::memory_order_relaxed);
+      uint64_t end = 0;
+      do
+      {
+        end = batch_end(pos, messages);
+        if (end == 0 || has_space(pos, end - pos) == false)
+          return false;
+      }
+      while (!_header->reserve.compare_exchange_weak(pos, end, std::memory_order_relaxed));
+
+      write_batch(pos, messages);
+      // Claims are published in order
+      while (_header->tail.load(std::memory_order_acquire) != pos)
+        std::this_thread::yield();
+      _header->tail.store(end, std::memory_order_release);
+      wake_consumer();
+      return true;
+    }
+    else
+    {
+      const uint64_t end = batch_end(_tail, messages);
+      if (end == 0 || has_space(_tail, end - _tail) == false)
+        return false;
+      write_batch(_tail, messages);
+      _tail = end;
+      publish();
+      return true;
+    }
+  }
+
+  // Consumer side
+
+  // Returns the next message, it stays in the ring until pop().
+  // Span with null data means there are no messages
+  [[nodiscard]]
+  std::span<const value_type> front()
+  {
+    while (true)
+    {
+      if (_head == _tail_cache)
+      {
+        _tail_cache = _header->tail.load(std::memory_order_acquire);
+        if (_head == _tail_cache)
+          return {};
+      }
+
+      auto record = read_record(_head);
+      if (record.flags & detail::shared_ring_record::skip)
+      {
+        _head += _capacity - offset(_head);
+        continue;
+      }
+      return {payload(_head), record.len};
+    }
+  }
+
+  // Drops the message returned by front(), space is given
+  // back to producers only after release()
+  void pop()
+  {
+    _head += detail::shared_ring_record_size(read_record(_head).len);
+  }
+
+  void release()
+  {
+    _header->head.store(_head, std::memory_order_release);
+    wake_producers();
+  }
+
+  // Calls `fn(message)` for up to `max_count` messages and releases
+  // their space at once. Returns count of consumed messages
+  template<class Fn>
+  size_t consume(Fn && fn, size_t max_count = SIZE_MAX)
+  {
+    size_t count = 0;
+    for (; count < max_count; ++count)
+    {
+      auto message = front();
+      if (message.data() == nullptr)
+        break;
+      fn(message);
+      pop();
+    }
+    if (count > 0)
+      release();
+    return count;
+  }
+
+#ifdef __linux__
+  // Returns false if there are still no messages after `timeout`
+  bool wait_readable(std::chrono::nanoseconds timeout)
+  {
+    return wait(_header->data_seq, _header->consumer_waiting, timeout,
+                [this] { return readable(); });
+  }
+
+  // Returns false if there is still no space for a message
+  // of `len` bytes after `timeout`
+  bool wait_writable(size_t len, std::chrono::nanoseconds timeout)
+  {
+    return wait(_header->space_seq, _header->producers_waiting, timeout,
+                [this, len] { return writable(len); });
+  }
+#endif // __linux__
+
+  size_t capacity() const noexcept { return _capacity; }
+
+  // Bigger messages are rejected, so a message always fits an empty ring
+  size_t max_message_size() const noexcept
+  {
+    return _capacity / 2 - sizeof(detail::shared_ring_record);
+  }
+
+private:
+  detail::shared_ring_header * _header;
+  value_type * _data{nullptr};
+  size_t _capacity{0};
+  // Producer state, the tail includes committed but unpublished messages
+  uint64_t _tail{0};
+  uint64_t _head_cache{0};
+  size_t _prepared{0};
+  // Consumer state, the head includes popped but unreleased messages
+  uint64_t _head{0};
+  uint64_t _tail_cache{0};
+
+  size_t offset(uint64_t pos) const noexcept
+  {
+    return static_cast<size_t>(pos & (_capacity - 1));
+  }
+
+  value_type * payload(uint64_t pos) const noexcept
+  {
+    return _data + offset(pos) + sizeof(detail::shared_ring_record);
+  }
+
+  // Space for a record at `pos`, including the skipped tail of the data
+  // if the record doesn't fit before the end of it
+  size_t claim_size(uint64_t pos, size_t len) const noexcept
+  {
+    const size_t record = detail::shared_ring_record_size(len);
+    const size_t to_end = _capacity - offset(pos);
+    return record <= to_end ? record : to_end + record;
+  }
+
+  // Returns end of the batch placed at `pos`, 0 if a message is too big
+  uint64_t batch_end(uint64_t pos, std::span<const std::span<const value_type>> messages) const noexcept
+  {
+    for (auto & it : messages)
+    {
+      if (it.size() > max_message_size())
+        return 0;
+      pos += claim_size(pos, it.size());
+    }
+    return pos;
+  }
+
+  void write_batch(uint64_t pos, std::span<const std::span<const value_type>> messages) noexcept
+  {
+    for (auto & it : messages)
+    {
+      if (claim_size(pos, it.size()) != detail::shared_ring_record_size(it.size()))
+      {
+        write_skip(pos);
+        pos += _capacity - offset(pos);
+      }
+      ::memcpy(payload(pos), it.data(), it.size());
+      write_record(pos, static_cast<uint32_t>(it.size()));
+      pos += detail::shared_ring_record_size(it.size());
+    }
+  }
+
+  bool has_space(uint64_t pos, size_t need)
+  {
+    if (pos + need - _head_cache <= _capacity)
+      return true;
+    _head_cache = _header->head.load(std::memory_order_acquire);
+    return pos + need - _head_cache <= _capacity;
+  }
+
+  bool readable()
+  {
+    return _head != _header->tail.load(std::memory_order_acquire);
+  }
+
+  bool writable(size_t len)
+  {
+    uint64_t pos = MultiProducer ? _header->reserve.load(std::memory_order_relaxed) : _tail;
+    return len <= max_message_size() && has_space(pos, claim_size(pos, len));
+  }
+
+  // Records are aligned and never cross the end of the data
+  detail::shared_ring_record read_record(uint64_t pos) const noexcept
+  {
+    detail::shared_ring_record ret;
+    ::memcpy(&ret, _data + offset(pos), sizeof(ret));
+    return ret;
+  }
+
+  void write_record(uint64_t pos, uint32_t len) noexcept
+  {
+    detail::shared_ring_record record{len, 0, 0};
+    ::memcpy(_data + offset(pos), &record, sizeof(record));
+  }
+
+  void write_skip(uint64_t pos) noexcept
+  {
+    detail::shared_ring_record record{0, detail::shared_ring_record::skip, 0};
+    ::memcpy(_data + offset(pos), &record, sizeof(record));
+  }
+
+#ifdef __linux__
+  // The other side bumps `seq` after the change if it sees `waiters`
+  template<class Ready>
+  static bool wait(std::atomic<uint32_t> & seq, std::atomic<uint32_t> & waiters,
+                   std::chrono::nanoseconds timeout, Ready ready)
+  {
+    if (ready())
+      return true;
+
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    waiters.fetch_add(1, std::memory_order_relaxed);
+    bool ret = false;
+    while (true)
+    {
+      uint32_t value = seq.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      ret = ready();
+      auto left = deadline - std::chrono::steady_clock::now();
+      if (ret || left <= std::chrono::nanoseconds::zero())
+        break;
+      // Wakes up on a bump, a timeout or a signal, all of them are rechecked
+      detail::futex_wait(seq, value, left);
+    }
+    waiters.fetch_sub(1, std::memory_order_relaxed);
+    return ret;
+  }
+#endif // __linux__
+
+  void wake_consumer() noexcept
+  {
+#ifdef __linux__
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_header->consumer_waiting.load(std::memory_order_relaxed) != 0)
+    {
+      _header->data_seq.fetch_add(1, std::memory_order_release);
+      detail::futex_wake(_header->data_seq, 1);
+    }
+#endif // __linux__
+  }
+
+  void wake_producers() noexcept
+  {
+#ifdef __linux__
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_header->producers_waiting.load(std::memory_order_relaxed) != 0)
+    {
+      _header->space_seq.fetch_add(1, std::memory_order_release);
+      detail::futex_wake(_header->space_seq, INT_MAX);
+    }
+#endif // __linux__
+  }
+
+  // Runs in the process that won the segment, others wait for `ready`
+  void format(size_t segment_size)
+  {
+    const size_t data_offset = (sizeof(detail::shared_ring_header) + 63) / 64 * 64;
+    const size_t capacity = segment_size > data_offset ? std::bit_floor(segment_size - data_offset) : 0;
+    assert(capacity >= 4 * sizeof(detail::shared_ring_record) && "Segment is too small for a ring");
+
+    _header->multi_producer = MultiProducer;
+    _header->magic = detail::shared_ring_header::magic_value;
+    _header->capacity = capacity;
+    _header->data_offset = data_offset;
+    _header->state.store(detail::shared_ring_header::ready, std::memory_order_release);
+  }
+};
+
+using spsc_ring = shared_ring<false>;
+using mpsc_ring = shared_ring<true>;
+
+} // namespace ac
+
+#endif // SHARED_RING_HPP
@@ -0,0 +1,218 @@
+#ifndef SIZE_CLASS_ALLOCATOR_HPP
+#define SIZE_CLASS_ALLOCATOR_HPP
+
+#include "ac_concepts.hpp"
+#include "intrusive_chunk_allocator.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+#include <cassert>
+
+namespace ac
+{
+
+// One pool of the size-class allocator
+struct size_class
+{
+  size_t chunk_size;
+  size_t chunks_count;
+};
+
+// Counters of one class, allocations and requested bytes are cumulative,
+// so requested_bytes / (allocations * chunk_size) is the fill of chunks
+struct size_class_stats
+{
+  size_t chunk_size{0};
+  size_t chunks_count{0};
+  size_t in_use{0};
+  size_t high_water{0};
+  uint64_t allocations{0};
+  uint64_t requested_bytes{0};
+  // Requests of this class served by a bigger one
+  uint64_t spills{0};
+  // Requests of this class no class could serve
+  uint64_t failures{0};
+};
+
+// Power-of-two classes from `min_size` up to `max_size`,
+// each of them gets `bytes_per_class` of the buffer
+inline std::vector<size_class> geometric_size_classes(size_t min_size, size_t max_size,
+                                                      size_t bytes_per_class)
+{
+  std::vector<size_class> ret;
+  for (size_t size = std::bit_ceil(min_size); size <= max_size; size *= 2)
+    ret.push_back(size_class{size, std::max<size_t>(bytes_per_class / size, 1)});
+  return ret;
+}
+
+// Serves variable-size requests from a set of single-size pools carved from
+// one caller-supplied buffer. A request takes a chunk of the smallest class
+// that fits it, or of the next bigger one if that class is exhausted.
+//
+// Every pool starts at a page boundary (relative to the buffer), so the
+// class of a freed pointer is a lookup in a per-page table. The class of a
+// request is a lookup in a table indexed by size in 16-byte granules.
+// Both are O(1). Class sizes MUST be ascending multiples of the granule.
+// Pool allocators are constructed as Pool(buf, buf_len, chunk_size).
+// Isn't thread-safe, like the pools.
+
+template<IsChunkAllocator Pool = intrusive_chunk_allocator>
+class size_class_allocator
+{
+public:
+  using pool_type = Pool;
+  using value_type = typename pool_type::value_type;
+  using chunk_type = typename pool_type::chunk_type;
+
+  static constexpr size_t page_size = 4096;
+  static constexpr size_t granule = alignof(std::max_align_t);
+
+public:
+  size_class_allocator(value_type * buf, size_t buf_len, std::span<const size_class> classes) :
+    _buf{buf, buf_len},
+    _page_class((buf_len + page_size - 1) / page_size, npos)
+  {
+    assert(classes.empty() == false && "There MUST be at least one class");
+    assert(classes.size() < npos && "Too many classes to index");
+    assert(required_size(classes) <= buf_len && "Buffer is too small for the classes");
+
+    _pools.reserve(classes.size());
+    _stats.reserve(classes.size());
+    size_t offset = 0;
+    for (size_t i = 0; i < classes.size(); ++i)
+    {
+      const size_t chunk_size = classes[i].chunk_size;
+      assert(chunk_size > 0 && chunk_size % granule == 0 && "Class size MUST be a multiple of the granule");
+      assert((i == 0 || classes[i - 1].chunk_size < chunk_size) && "Classes MUST be ascending");
+
+      // Tail of the last page goes to the class too
+      const size_t region_len = round_up(chunk_size * classes[i].chunks_count, page_size);
+      const size_t pool_len = region_len - region_len % chunk_size;
+      _pools.emplace_back(buf + offset, pool_len, chunk_size);
+      std::fill_n(_page_class.begin() + offset / page_size, region_len / page_size, static_cast<class_id_type>(i));
+
+      auto & stats = _stats.emplace_back();
+      stats.chunk_size = chunk_size;
+      stats.chunks_count = _pools.back().size();
+      offset += region_len;
+    }
+
+    _size_class.resize(classes.back().chunk_size / granule + 1);
+    for (size_t i = 0, class_id = 0; i < _size_class.size(); ++i)
+    {
+      while (classes[class_id].chunk_size < i * granule)
+        ++class_id;
+      _size_class[i] = static_cast<class_id_type>(class_id);
+    }
+  }
+
+  // Bytes of the buffer needed for `classes`
+  static constexpr size_t required_size(std::span<const size_class> classes) noexcept
+  {
+    size_t ret = 0;
+    for (auto & it : classes)
+      ret += round_up(it.chunk_size * it.chunks_count, page_size);
+    return ret;
+  }
+
+  // Returns a chunk of at least `len` bytes, it may be bigger than requested
+  [[nodiscard]]
+  chunk_type allocate(size_t len)
+  {
+    if (len > max_size())
+      return {};
+
+    const size_t class_id = _size_class[(len + granule - 1) / granule];
+    auto & stats = _stats[class_id];
+    ++stats.allocations;
+    stats.requested_bytes += len;
+
+    for (size_t i = class_id; i < _pools.size(); ++i)
+    {
+      auto chunk = _pools[i].allocate();
+      if (chunk.empty())
+        continue;
+
+      if (i != class_id)
+        ++stats.spills;
+      auto & owner = _stats[i];
+      owner.high_water = std::max(++owner.in_use, owner.high_water);
+      return chunk;
+    }
+    ++stats.failures;
+    return {};
+  }
+
+  // Class is recovered from the pointer, so only the beginning of the chunk
+  // is needed. Pointers from outside of the pools are ignored
+  void deallocate(value_type * ptr)
+  {
+    if (ptr < _buf.data() || ptr >= _buf.data() + _buf.size())
+      return;
+
+    const size_t class_id = _page_class[(ptr - _buf.data()) / page_size];
+    if (class_id == npos)
+      return;
+
+    auto & pool = _pools[class_id];
+    const size_t in_use = pool.in_use();
+    pool.deallocate(chunk_type{ptr, _stats[class_id].chunk_size});
+    // The pool ignores chunks it doesn't own
+    if (pool.in_use() != in_use)
+      --_stats[class_id].in_use;
+  }
+
+  void deallocate(chunk_type chunk)
+  {
+    deallocate(chunk.data());
+  }
+
+  // The biggest request that may be served
+  size_t max_size() const noexcept { return _stats.back().chunk_size; }
+  size_t classes_count() const noexcept { return _pools.size(); }
+
+  const size_class_stats & stats(size_t class_id) const noexcept { return _stats[class_id]; }
+
+  size_t size() const noexcept
+  {
+    size_t ret = 0;
+    for (auto & it : _pools)
+      ret += it.size();
+    return ret;
+  }
+
+  size_t in_use() const noexcept
+  {
+    size_t ret = 0;
+    for (auto & it : _pools)
+      ret += it.in_use();
+    return ret;
+  }
+
+  size_t remain() const noexcept { return size() - in_use(); }
+
+private:
+  using class_id_type = uint8_t;
+  static constexpr class_id_type npos = std::numeric_limits<class_id_type>::max();
+
+  chunk_type _buf;
+  std::vector<pool_type> _pools;
+  std::vector<size_class_stats> _stats;
+  // Class of every page of the buffer
+  std::vector<class_id_type> _page_class;
+  // Smallest class for a request of `i` granules
+  std::vector<class_id_type> _size_class;
+
+  static constexpr size_t round_up(size_t len, size_t align) noexcept
+  {
+    return (len + align - 1) / align * align;
+  }
+};
+
+} // namespace ac
+
+#endif // SIZE_CLASS_ALLOCATOR_HPP
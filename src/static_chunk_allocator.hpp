@@ -1,6 +1,7 @@
 #ifndef STATIC_CHUNK_ALLOCATOR_HPP
 #define STATIC_CHUNK_ALLOCATOR_HPP
 
+#include <algorithm>
 #include <deque>
 #include <cstddef>
 #include <numeric>
@@ -48,6 +49,22 @@ public:
     _unused_chunk_ids.push_back(chunk_place / _chunk_size);
   }
 
+  [[nodiscard]]
+  size_t allocate_n(std::span<chunk_type> out)
+  {
+    size_t count = std::min(out.size(), _unused_chunk_ids.size());
+    for (size_t i = 0; i < count; ++i)
+      out[i] = _buf.subspan(_chunk_size * _unused_chunk_ids[i], _chunk_size);
+    _unused_chunk_ids.erase(_unused_chunk_ids.begin(), _unused_chunk_ids.begin() + count);
+    return count;
+  }
+
+  void deallocate_n(std::span<const chunk_type> chunks)
+  {
+    for (auto & it : chunks)
+      deallocate(it);
+  }
+
   size_t size()   const noexcept { return _chunks_count; }
   size_t remain() const noexcept { return _unused_chunk_ids.size(); }
   size_t in_use() const noexcept { return size() - remain(); }
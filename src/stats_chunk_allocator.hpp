@@ -0,0 +1,249 @@
+#ifndef STATS_CHUNK_ALLOCATOR_HPP
+#define STATS_CHUNK_ALLOCATOR_HPP
+
+#include "ac_concepts.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Define as 0 to turn every stats_chunk_allocator into a plain pass-through
+#ifndef AC_STATS_ENABLED
+#define AC_STATS_ENABLED 1
+#endif
+
+namespace ac
+{
+
+struct chunk_allocator_stats
+{
+  // Bucket `i` counts allocate() calls that took [2^(i-1), 2^i) nanoseconds
+  static constexpr size_t latency_buckets = 32;
+
+  // Counters are monotonic, rates are the difference of two snapshots
+  uint64_t allocations{0};
+  uint64_t deallocations{0};
+  // allocate() calls returned an empty chunk
+  uint64_t failures{0};
+  size_t in_use{0};
+  size_t high_water{0};
+  std::array<uint64_t, latency_buckets> allocate_latency{};
+};
+
+namespace detail
+{
+
+inline constexpr size_t stats_stripes = 16;
+
+// Threads are spread over stripes, so they rarely share a cache line
+struct alignas(64) stats_stripe
+{
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> deallocations{0};
+  std::atomic<uint64_t> failures{0};
+  // Chunks allocated minus chunks freed by the stripe's threads, negative
+  // when they free chunks taken by other threads
+  std::atomic<int64_t> live{0};
+  std::atomic<int64_t> live_peak{0};
+  std::array<std::atomic<uint64_t>, chunk_allocator_stats::latency_buckets> allocate_latency{};
+};
+
+inline size_t stats_stripe_id() noexcept
+{
+  static std::atomic<size_t> next_id{0};
+  static thread_local size_t id = next_id.fetch_add(1, std::memory_order_relaxed) % stats_stripes;
+  return id;
+}
+
+inline void add(std::atomic<uint64_t> & counter, uint64_t value) noexcept
+{
+  counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+} // namespace detail
+
+// Counts calls to the wrapped allocator. Thread-safe if the wrapped one is.
+// Every deallocate() call with a non-empty chunk is counted, even if the
+// allocator ignores it. Counters are striped per thread and summed up by
+// snapshot(). in_use is taken from the wrapped allocator by snapshot(), so
+// only frees it accepted count. The high-water mark is the sum of the stripes'
+// live counts, checked when a stripe's own live count reaches a new peak and
+// on snapshot(). It can miss a peak made of chunks held by several threads
+// when none of them sets its own new peak at that moment, or after frees the
+// allocator ignored, as they still lower the live counts.
+
+template<IsChunkAllocator Allocator, bool Enabled = AC_STATS_ENABLED>
+class stats_chunk_allocator
+{
+public:
+  using allocator_type = Allocator;
+  using value_type = typename allocator_type::value_type;
+  using chunk_type = typename allocator_type::chunk_type;
+  using clock_type = std::chrono::steady_clock;
+
+public:
+  template<class ... Args>
+  stats_chunk_allocator(Args &&... args) :
+    _allocator{std::forward<Args>(args)...}
+  {}
+
+  [[nodiscard]]
+  chunk_type allocate()
+  {
+    auto start = clock_type::now();
+    auto chunk = _allocator.allocate();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start);
+
+    auto & stripe = _stripes[detail::stats_stripe_id()];
+    detail::add(stripe.allocate_latency[latency_bucket(elapsed.count())], 1);
+    if (chunk.empty())
+    {
+      detail::add(stripe.failures, 1);
+      return chunk;
+    }
+
+    detail::add(stripe.allocations, 1);
+    add_live(stripe, 1);
+    return chunk;
+  }
+
+  void deallocate(chunk_type chunk)
+  {
+    _allocator.deallocate(chunk);
+    if (chunk.empty())
+      return;
+
+    auto & stripe = _stripes[detail::stats_stripe_id()];
+    detail::add(stripe.deallocations, 1);
+    add_live(stripe, -1);
+  }
+
+  [[nodiscard]]
+  size_t allocate_n(std::span<chunk_type> out)
+  {
+    size_t count = ac::allocate_n(_allocator, out);
+
+    auto & stripe = _stripes[detail::stats_stripe_id()];
+    detail::add(stripe.allocations, count);
+    if (count < out.size())
+      detail::add(stripe.failures, 1);
+    if (count > 0)
+      add_live(stripe, static_cast<int64_t>(count));
+    return count;
+  }
+
+  void deallocate_n(std::span<const chunk_type> chunks)
+  {
+    ac::deallocate_n(_allocator, chunks);
+    auto count = std::ranges::count_if(chunks, [](const chunk_type & it) { return it.empty() == false; });
+    if (count == 0)
+      return;
+
+    auto & stripe = _stripes[detail::stats_stripe_id()];
+    detail::add(stripe.deallocations, static_cast<uint64_t>(count));
+    add_live(stripe, -static_cast<int64_t>(count));
+  }
+
+  size_t size()   const noexcept { return _allocator.size(); }
+  size_t remain() const noexcept { return _allocator.remain(); }
+  size_t in_use() const noexcept { return _allocator.in_use(); }
+
+  // Counters may be slightly inconsistent with each other
+  // if the allocator is used while snapshot is taken
+  chunk_allocator_stats snapshot() const noexcept
+  {
+    chunk_allocator_stats ret;
+    for (auto & stripe : _stripes)
+    {
+      ret.allocations += stripe.allocations.load(std::memory_order_relaxed);
+      ret.deallocations += stripe.deallocations.load(std::memory_order_relaxed);
+      ret.failures += stripe.failures.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < ret.allocate_latency.size(); ++i)
+        ret.allocate_latency[i] += stripe.allocate_latency[i].load(std::memory_order_relaxed);
+    }
+    ret.in_use = _allocator.in_use();
+    ret.high_water = std::max({_high_water.load(std::memory_order_relaxed), live_sum(), ret.in_use});
+    return ret;
+  }
+
+private:
+  allocator_type _allocator;
+  std::array<detail::stats_stripe, detail::stats_stripes> _stripes;
+  alignas(64) std::atomic<size_t> _high_water{0};
+
+  static size_t latency_bucket(int64_t nanoseconds) noexcept
+  {
+    auto width = static_cast<size_t>(std::bit_width(static_cast<uint64_t>(std::max<int64_t>(nanoseconds, 0))));
+    return std::min(width, chunk_allocator_stats::latency_buckets - 1);
+  }
+
+  size_t live_sum() const noexcept
+  {
+    int64_t sum = 0;
+    for (const auto & stripe : _stripes)
+      sum += stripe.live.load(std::memory_order_relaxed);
+    return static_cast<size_t>(std::max<int64_t>(sum, 0));
+  }
+
+  // Only the stripe's threads write its live count, other stripes are read
+  // when this one grows past its own peak
+  void add_live(detail::stats_stripe & stripe, int64_t count) noexcept
+  {
+    int64_t live = stripe.live.fetch_add(count, std::memory_order_relaxed) + count;
+    if (live <= stripe.live_peak.load(std::memory_order_relaxed))
+      return;
+
+    stripe.live_peak.store(live, std::memory_order_relaxed);
+    raise_high_water();
+  }
+
+  void raise_high_water() noexcept
+  {
+    size_t current = live_sum();
+    size_t high_water = _high_water.load(std::memory_order_relaxed);
+    while (current > high_water
+           && !_high_water.compare_exchange_weak(high_water, current, std::memory_order_relaxed))
+    {}
+  }
+};
+
+// Disabled stats: no counters, every call goes straight to the allocator
+template<IsChunkAllocator Allocator>
+class stats_chunk_allocator<Allocator, false>
+{
+public:
+  using allocator_type = Allocator;
+  using value_type = typename allocator_type::value_type;
+  using chunk_type = typename allocator_type::chunk_type;
+
+public:
+  template<class ... Args>
+  stats_chunk_allocator(Args &&... args) :
+    _allocator{std::forward<Args>(args)...}
+  {}
+
+  [[nodiscard]]
+  chunk_type allocate() { return _allocator.allocate(); }
+  void deallocate(chunk_type chunk) { _allocator.deallocate(chunk); }
+
+  [[nodiscard]]
+  size_t allocate_n(std::span<chunk_type> out) { return ac::allocate_n(_allocator, out); }
+  void deallocate_n(std::span<const chunk_type> chunks) { ac::deallocate_n(_allocator, chunks); }
+
+  size_t size()   const noexcept { return _allocator.size(); }
+  size_t remain() const noexcept { return _allocator.remain(); }
+  size_t in_use() const noexcept { return _allocator.in_use(); }
+
+  chunk_allocator_stats snapshot() const noexcept { return {}; }
+
+private:
+  allocator_type _allocator;
+};
+
+} // namespace ac
+
+#endif // STATS_CHUNK_ALLOCATOR_HPP
@@ -2,6 +2,7 @@
 #define SYNC_CHUNK_ALLOCATOR_HPP
 
 #include "ac_concepts.hpp"
+#include <mutex>
 #include <shared_mutex>
 
 namespace ac
@@ -34,6 +35,19 @@ public:
     _allocator.deallocate(chunk);
   }
 
+  [[nodiscard]]
+  size_t allocate_n(std::span<chunk_type> out)
+  {
+    std::unique_lock lock(_mutex);
+    return ac::allocate_n(_allocator, out);
+  }
+
+  void deallocate_n(std::span<const chunk_type> chunks)
+  {
+    std::unique_lock lock(_mutex);
+    ac::deallocate_n(_allocator, chunks);
+  }
+
   size_t size() const noexcept
   {
     std::shared_lock lock(_mutex);
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include "bitmap_chunk_allocator.hpp"
+
+TEST(bitmap_chunk_allocator_test, single_allocation)
+{
+  std::byte buf[1024] {};
+  ac::bitmap_chunk_allocator allocator{buf, sizeof(buf), 512};
+
+  ASSERT_EQ(2, allocator.size());
+
+  auto chunk = allocator.allocate();
+  EXPECT_EQ(512, chunk.size());
+  EXPECT_EQ(buf, chunk.data());
+  EXPECT_EQ(1, allocator.in_use());
+  EXPECT_EQ(1, allocator.remain());
+}
+
+TEST(bitmap_chunk_allocator_test, all_mem_exceed)
+{
+  std::byte buf[1024] {};
+  ac::bitmap_chunk_allocator allocator{buf, sizeof(buf), 1024};
+
+  auto chunk1 = allocator.allocate();
+  auto chunk2 = allocator.allocate();
+  EXPECT_EQ(1024, chunk1.size());
+  EXPECT_EQ(0, allocator.remain());
+  EXPECT_TRUE(chunk2.empty());
+}
+
+TEST(bitmap_chunk_allocator_test, lowest_address_first)
+{
+  // More than 64 * 64 chunks to involve several summary words
+  static std::byte buf[5000 * 4] {};
+  ac::bitmap_chunk_allocator allocator{buf, sizeof(buf), 4};
+
+  ASSERT_EQ(5000, allocator.size());
+
+  std::vector<ac::bitmap_chunk_allocator::chunk_type> chunks;
+  for (size_t i = 0; i < allocator.size(); ++i)
+  {
+    chunks.push_back(allocator.allocate());
+    EXPECT_EQ(buf + i * 4, chunks.back().data());
+  }
+  EXPECT_TRUE(allocator.allocate().empty());
+
+  allocator.deallocate(chunks[4500]);
+  allocator.deallocate(chunks[70]);
+  EXPECT_EQ(2, allocator.remain());
+
+  EXPECT_EQ(chunks[70].data(), allocator.allocate().data());
+  EXPECT_EQ(chunks[4500].data(), allocator.allocate().data());
+  EXPECT_EQ(0, allocator.remain());
+}
+
+TEST(bitmap_chunk_allocator_test, adjacent_run)
+{
+  std::byte buf[200 * 8] {};
+  ac::bitmap_chunk_allocator allocator{buf, sizeof(buf), 8};
+
+  auto first = allocator.allocate();
+  auto run = allocator.allocate(100);
+  ASSERT_EQ(800, run.size());
+  EXPECT_EQ(buf + 8, run.data());
+  EXPECT_EQ(101, allocator.in_use());
+
+  // Hole of one chunk is too small for a run of two
+  allocator.deallocate(first);
+  auto pair = allocator.allocate(2);
+  EXPECT_EQ(buf + 101 * 8, pair.data());
+
+  // Run can't fit in the rest
+  EXPECT_TRUE(allocator.allocate(98).empty());
+
+  allocator.deallocate(run);
+  EXPECT_EQ(2, allocator.in_use());
+
+  // Now the run spanning several words fits at the start
+  auto big = allocator.allocate(101);
+  EXPECT_EQ(buf, big.data());
+  EXPECT_EQ(103, allocator.in_use());
+}
+
+TEST(bitmap_chunk_allocator_test, deallocate_wrong_pointer)
+{
+  std::byte buf[1024] {};
+  ac::bitmap_chunk_allocator allocator{buf, sizeof(buf), 512};
+
+  auto chunk = allocator.allocate();
+
+  allocator.deallocate(chunk.subspan(1));
+  allocator.deallocate(ac::bitmap_chunk_allocator::chunk_type{});
+  EXPECT_EQ(1, allocator.in_use());
+
+  // Double free is ignored
+  allocator.deallocate(chunk);
+  allocator.deallocate(chunk);
+  EXPECT_EQ(0, allocator.in_use());
+  EXPECT_EQ(2, allocator.remain());
+}
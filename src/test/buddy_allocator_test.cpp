@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include "buddy_allocator.hpp"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+TEST(buddy_allocator_test, rounds_up_to_block)
+{
+  std::byte buf[1024] {};
+  ac::buddy_allocator allocator{buf, sizeof(buf), 64};
+
+  ASSERT_EQ(1024, allocator.size());
+  ASSERT_EQ(1024, allocator.max_block());
+
+  auto block = allocator.allocate(100);
+  EXPECT_EQ(128, block.size());
+  EXPECT_EQ(buf, block.data());
+  EXPECT_EQ(128, allocator.in_use());
+  EXPECT_EQ(896, allocator.remain());
+  EXPECT_EQ(512, allocator.largest_free());
+
+  EXPECT_EQ(64, allocator.allocate(1).size());
+  EXPECT_EQ(512, allocator.allocate(512).size());
+  EXPECT_TRUE(allocator.allocate(1025).empty());
+  EXPECT_TRUE(allocator.allocate(0).empty());
+}
+
+TEST(buddy_allocator_test, split_and_merge)
+{
+  std::byte buf[1024] {};
+  ac::buddy_allocator allocator{buf, sizeof(buf), 64};
+
+  std::vector<ac::buddy_allocator::chunk_type> blocks;
+  for (size_t i = 0; i < 16; ++i)
+  {
+    blocks.push_back(allocator.allocate(64));
+    ASSERT_EQ(64, blocks.back().size());
+  }
+  EXPECT_TRUE(allocator.allocate(64).empty());
+  EXPECT_EQ(0, allocator.largest_free());
+
+  for (auto & it : blocks)
+    allocator.deallocate(it);
+
+  // Everything is merged back into one block
+  EXPECT_EQ(0, allocator.in_use());
+  EXPECT_EQ(1024, allocator.largest_free());
+  EXPECT_EQ(1024, allocator.allocate(1024).size());
+}
+
+TEST(buddy_allocator_test, non_power_of_two_buffer)
+{
+  std::byte buf[64 * 13] {};
+  ac::buddy_allocator allocator{buf, sizeof(buf), 64};
+
+  // 13 blocks are 8 + 4 + 1
+  EXPECT_EQ(512, allocator.max_block());
+  auto big = allocator.allocate(512);
+  auto mid = allocator.allocate(256);
+  auto small = allocator.allocate(64);
+  EXPECT_EQ(buf, big.data());
+  EXPECT_EQ(buf + 512, mid.data());
+  EXPECT_EQ(buf + 768, small.data());
+  EXPECT_TRUE(allocator.allocate(64).empty());
+
+  // Top-level blocks aren't merged with each other
+  allocator.deallocate(small);
+  allocator.deallocate(mid);
+  EXPECT_EQ(256, allocator.largest_free());
+  allocator.deallocate(big);
+  EXPECT_EQ(512, allocator.largest_free());
+  EXPECT_EQ(0, allocator.in_use());
+}
+
+TEST(buddy_allocator_test, invalid_deallocation)
+{
+  std::byte buf[1024] {};
+  ac::buddy_allocator allocator{buf, sizeof(buf), 64};
+
+  auto block = allocator.allocate(128);
+  // Wrong size, misaligned, foreign and double free are ignored
+  allocator.deallocate(block.first(64));
+  allocator.deallocate(block.subspan(64));
+  std::byte foreign[128] {};
+  allocator.deallocate(foreign);
+  EXPECT_EQ(128, allocator.in_use());
+
+  allocator.deallocate(block);
+  allocator.deallocate(block);
+  EXPECT_EQ(0, allocator.in_use());
+  EXPECT_EQ(1024, allocator.largest_free());
+}
+
+TEST(buddy_allocator_test, random_mixed_sizes)
+{
+  std::vector<std::byte> buf(64 << 10);
+  ac::buddy_allocator allocator{buf.data(), buf.size(), 32};
+
+  struct tagged_block
+  {
+    ac::buddy_allocator::chunk_type block;
+    std::byte tag;
+  };
+
+  std::mt19937_64 rng{42};
+  std::vector<tagged_block> blocks;
+  for (size_t step = 0; step < 10000; ++step)
+  {
+    if (blocks.empty() == false && rng() % 2 == 0)
+    {
+      size_t i = rng() % blocks.size();
+      allocator.deallocate(blocks[i].block);
+      blocks[i] = blocks.back();
+      blocks.pop_back();
+      continue;
+    }
+
+    auto block = allocator.allocate(1 + rng() % 4096);
+    if (block.empty())
+      continue;
+    auto tag = static_cast<std::byte>(step);
+    std::fill(block.begin(), block.end(), tag);
+    blocks.push_back(tagged_block{block, tag});
+  }
+
+  // Blocks never overlap, so nobody overwrote them
+  size_t in_use = 0;
+  for (auto & it : blocks)
+  {
+    in_use += it.block.size();
+    EXPECT_TRUE(std::all_of(it.block.begin(), it.block.end(),
+                            [&](std::byte b) { return b == it.tag; }));
+  }
+  EXPECT_EQ(in_use, allocator.in_use());
+
+  for (auto & it : blocks)
+    allocator.deallocate(it.block);
+  EXPECT_EQ(0, allocator.in_use());
+  EXPECT_EQ(buf.size(), allocator.largest_free());
+}
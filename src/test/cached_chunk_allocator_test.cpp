@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include "cached_chunk_allocator.hpp"
+#include "intrusive_chunk_allocator.hpp"
+#include "static_chunk_allocator.hpp"
+#include "sync_chunk_allocator.hpp"
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using cached_allocator =
+  ac::cached_chunk_allocator<ac::sync_chunk_allocator<ac::static_chunk_allocator>>;
+
+TEST(cached_chunk_allocator_test, refill_by_batch)
+{
+  std::byte buf[1024] {};
+  cached_allocator allocator{8, buf, sizeof(buf), 16ul};
+
+  ASSERT_EQ(64, allocator.size());
+
+  auto chunk = allocator.allocate();
+  EXPECT_EQ(16, chunk.size());
+  EXPECT_EQ(1, allocator.in_use());
+  EXPECT_EQ(63, allocator.remain());
+  // Half of magazine is taken from the backend at once
+  EXPECT_EQ(3, allocator.cached());
+}
+
+TEST(cached_chunk_allocator_test, same_thread_reuse)
+{
+  std::byte buf[1024] {};
+  cached_allocator allocator{8, buf, sizeof(buf), 16ul};
+
+  auto chunk = allocator.allocate();
+  allocator.deallocate(chunk);
+  EXPECT_EQ(0, allocator.in_use());
+  EXPECT_EQ(4, allocator.cached());
+
+  // Last freed chunk is hot in cache, so it goes out first
+  EXPECT_EQ(chunk.data(), allocator.allocate().data());
+}
+
+TEST(cached_chunk_allocator_test, flush_when_full)
+{
+  std::byte buf[1024] {};
+  cached_allocator allocator{8, buf, sizeof(buf), 16ul};
+
+  cached_allocator::chunk_type chunks[64];
+  for (auto & it : chunks)
+  {
+    it = allocator.allocate();
+    EXPECT_FALSE(it.empty());
+  }
+  EXPECT_TRUE(allocator.allocate().empty());
+  EXPECT_EQ(0, allocator.remain());
+
+  for (auto & it : chunks)
+  {
+    allocator.deallocate(it);
+    EXPECT_LE(allocator.cached(), allocator.magazine_size());
+  }
+  EXPECT_EQ(0, allocator.in_use());
+  EXPECT_EQ(64, allocator.remain());
+}
+
+TEST(cached_chunk_allocator_test, trim)
+{
+  std::byte buf[1024] {};
+  cached_allocator allocator{8, buf, sizeof(buf), 16ul};
+
+  allocator.deallocate(allocator.allocate());
+  EXPECT_NE(0, allocator.cached());
+
+  allocator.trim();
+  EXPECT_EQ(0, allocator.cached());
+  EXPECT_EQ(64, allocator.remain());
+}
+
+TEST(cached_chunk_allocator_test, flush_on_thread_exit)
+{
+  static std::byte buf[16 * 1024] {};
+  cached_allocator allocator{16, buf, sizeof(buf), 16ul};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([&allocator]
+    {
+      cached_allocator::chunk_type chunks[100];
+      for (int round = 0; round < 100; ++round)
+      {
+        for (auto & it : chunks)
+        {
+          it = allocator.allocate();
+          ASSERT_FALSE(it.empty());
+        }
+        for (auto & it : chunks)
+          allocator.deallocate(it);
+      }
+      EXPECT_NE(0, allocator.cached());
+    });
+  }
+  for (auto & it : threads)
+    it.join();
+
+  EXPECT_EQ(0, allocator.cached());
+  EXPECT_EQ(0, allocator.in_use());
+  EXPECT_EQ(allocator.size(), allocator.remain());
+}
+
+TEST(cached_chunk_allocator_test, trim_flushes_other_threads)
+{
+  std::byte buf[1024] {};
+  cached_allocator allocator{8, buf, sizeof(buf), 16ul};
+
+  std::promise<void> cached;
+  std::promise<void> trimmed;
+  std::promise<void> flushed;
+  std::promise<void> done;
+  std::thread thread([&]
+  {
+    auto chunk = allocator.allocate();
+    cached.set_value();
+    trimmed.get_future().wait();
+    // The magazine is flushed before the chunk is put to it
+    allocator.deallocate(chunk);
+    flushed.set_value();
+    done.get_future().wait();
+  });
+
+  cached.get_future().wait();
+  EXPECT_EQ(3, allocator.cached());
+  allocator.trim();
+  EXPECT_EQ(3, allocator.cached());
+
+  trimmed.set_value();
+  flushed.get_future().wait();
+  EXPECT_EQ(1, allocator.cached());
+  EXPECT_EQ(64, allocator.remain());
+
+  done.set_value();
+  thread.join();
+}
+
+TEST(cached_chunk_allocator_test, backend_untouched_after_destruction)
+{
+  using intrusive_cached =
+    ac::cached_chunk_allocator<ac::sync_chunk_allocator<ac::intrusive_chunk_allocator>>;
+
+  std::vector<std::byte> buf(1024);
+  auto allocator = std::make_unique<intrusive_cached>(8, buf.data(), buf.size(), 16ul);
+
+  std::promise<void> cached;
+  std::promise<void> destroyed;
+  std::thread thread([&]
+  {
+    allocator->deallocate(allocator->allocate());
+    cached.set_value();
+    // The magazine is released on exit, after the buffer is reused
+    destroyed.get_future().wait();
+  });
+
+  cached.get_future().wait();
+  allocator.reset();
+  std::fill(buf.begin(), buf.end(), std::byte{0x5a});
+
+  destroyed.set_value();
+  thread.join();
+  EXPECT_TRUE(std::all_of(buf.begin(), buf.end(), [](std::byte it) { return it == std::byte{0x5a}; }));
+}
@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
 #include "static_chunk_allocator.hpp"
 #include "chunk_list_wrapper.hpp"
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
 
 class chunk_controller_test : public ::testing::Test
 {
@@ -165,3 +170,478 @@ TEST_F(chunk_controller_test, read_in_the_end_of_last_chunk)
   EXPECT_EQ((std::byte)0x03, copy_buf[0]);
   EXPECT_EQ((std::byte)0x04, copy_buf[511]);
 }
+
+TEST_F(chunk_controller_test, clear_returns_all_chunks)
+{
+  ac::chunk_list_wrapper ctl{*_alloc};
+
+  std::byte buf[1024] {};
+  buf[1023] = (std::byte)0x05;
+  size_t written = ctl.write(buf, sizeof(buf));
+  EXPECT_EQ(1024, written);
+  EXPECT_EQ(0, _alloc->remain());
+
+  ctl.clear();
+  EXPECT_EQ(0, ctl.size());
+  EXPECT_EQ(2, _alloc->remain());
+
+  // Wrapper is usable after clear
+  written = ctl.write(buf, sizeof(buf));
+  EXPECT_EQ(1024, written);
+
+  std::byte copy_buf[1024] {};
+  size_t read = ctl.read_copy(0, copy_buf, sizeof(copy_buf));
+  EXPECT_EQ(1024, read);
+  EXPECT_EQ((std::byte)0x05, copy_buf[1023]);
+}
+
+TEST_F(chunk_controller_test, readable_segments)
+{
+  ac::chunk_list_wrapper ctl{*_alloc};
+
+  std::byte buf[1000] {};
+  buf[300] = (std::byte)0x01;
+  buf[600] = (std::byte)0x02;
+  size_t written = ctl.write(buf, sizeof(buf));
+  EXPECT_EQ(1000, written);
+  EXPECT_EQ(1000, ctl.size());
+  EXPECT_EQ(24, ctl.remain());
+
+  std::span<std::byte> segments[4];
+  size_t count = ctl.readable_segments(300, 10000, segments);
+  ASSERT_EQ(2, count);
+  EXPECT_EQ(212, segments[0].size());
+  EXPECT_EQ(488, segments[1].size());
+  EXPECT_EQ((std::byte)0x01, segments[0][0]);
+  EXPECT_EQ((std::byte)0x02, segments[1][88]);
+
+  // Not enough room for all segments
+  count = ctl.readable_segments(0, 1000, std::span{segments, 1});
+  ASSERT_EQ(1, count);
+  EXPECT_EQ(512, segments[0].size());
+
+  EXPECT_EQ(0, ctl.readable_segments(1000, 1, segments));
+}
+
+TEST_F(chunk_controller_test, writable_segments_and_commit)
+{
+  ac::chunk_list_wrapper ctl{*_alloc};
+
+  std::byte buf[100] {};
+  size_t written = ctl.write(buf, sizeof(buf));
+  EXPECT_EQ(100, written);
+
+  std::span<std::byte> segments[4];
+  size_t count = ctl.writable_segments(2000, segments);
+  // Only the rest of the pool is available
+  ASSERT_EQ(2, count);
+  EXPECT_EQ(412, segments[0].size());
+  EXPECT_EQ(512, segments[1].size());
+  EXPECT_EQ(0, _alloc->remain());
+
+  // Nothing is visible until commit
+  EXPECT_EQ(100, ctl.size());
+
+  segments[0][0] = (std::byte)0x03;
+  segments[1][0] = (std::byte)0x04;
+  ctl.commit(413);
+  EXPECT_EQ(513, ctl.size());
+  EXPECT_EQ(511, ctl.remain());
+
+  std::byte copy_buf[1024] {};
+  size_t read = ctl.read_copy(0, copy_buf, sizeof(copy_buf));
+  EXPECT_EQ(513, read);
+  EXPECT_EQ((std::byte)0x03, copy_buf[100]);
+  EXPECT_EQ((std::byte)0x04, copy_buf[512]);
+}
+
+#ifdef __linux__
+TEST_F(chunk_controller_test, readv_writev)
+{
+  ac::chunk_list_wrapper src{*_alloc};
+
+  std::byte buf[700] {};
+  for (size_t i = 0; i < sizeof(buf); ++i)
+    buf[i] = static_cast<std::byte>(i);
+  size_t written = src.write(buf, sizeof(buf));
+  ASSERT_EQ(700, written);
+
+  int fds[2];
+  ASSERT_EQ(0, ::pipe(fds));
+
+  iovec iov[4];
+  size_t count = src.readable_segments(0, src.size(), std::span{iov});
+  ASSERT_EQ(2, count);
+  EXPECT_EQ(700, ::writev(fds[1], iov, count));
+  src.clear();
+
+  ac::chunk_list_wrapper dst{*_alloc};
+  count = dst.writable_segments(700, std::span{iov});
+  ASSERT_EQ(2, count);
+  EXPECT_EQ(700, ::readv(fds[0], iov, count));
+  dst.commit(700);
+
+  std::byte copy_buf[700] {};
+  EXPECT_EQ(700, dst.read_copy(0, copy_buf, sizeof(copy_buf)));
+  EXPECT_EQ(0, ::memcmp(buf, copy_buf, sizeof(buf)));
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+#endif // __linux__
+
+TEST_F(chunk_controller_test, consume_releases_front_chunks)
+{
+  ac::chunk_list_wrapper ctl{*_alloc};
+
+  std::byte buf[1024] {};
+  buf[600] = (std::byte)0x01;
+  size_t written = ctl.write(buf, sizeof(buf));
+  EXPECT_EQ(1024, written);
+  EXPECT_EQ(0, _alloc->remain());
+
+  EXPECT_EQ(600, ctl.consume(600));
+  EXPECT_EQ(424, ctl.size());
+  // First chunk is fully consumed
+  EXPECT_EQ(1, _alloc->remain());
+
+  // Offsets are relative to the new head
+  std::byte * to_read = nullptr;
+  size_t read = ctl.read(0, to_read, 1000);
+  EXPECT_EQ(424, read);
+  EXPECT_EQ((std::byte)0x01, to_read[0]);
+
+  // Can't consume more than there is
+  EXPECT_EQ(424, ctl.consume(1000));
+  EXPECT_EQ(0, ctl.size());
+  EXPECT_EQ(2, _alloc->remain());
+}
+
+TEST_F(chunk_controller_test, stream_in_bounded_memory)
+{
+  ac::chunk_list_wrapper ctl{*_alloc};
+
+  std::byte buf[300] {};
+  std::byte copy_buf[300] {};
+  size_t total = 0;
+  for (int round = 0; round < 100; ++round)
+  {
+    for (size_t i = 0; i < sizeof(buf); ++i)
+      buf[i] = static_cast<std::byte>(total + i);
+
+    size_t written = ctl.write(buf, sizeof(buf));
+    ASSERT_EQ(300, written);
+    ASSERT_EQ(300, ctl.read_copy(ctl.size() - 300, copy_buf, sizeof(copy_buf)));
+    ASSERT_EQ(0, ::memcmp(buf, copy_buf, sizeof(buf)));
+
+    // Keep the tail of the message, so data always spans two chunks
+    ctl.consume(ctl.size() - 200);
+    total += sizeof(buf);
+  }
+  EXPECT_EQ(200, ctl.size());
+}
+
+TEST_F(chunk_controller_test, reserve_and_commit)
+{
+  ac::chunk_list_wrapper ctl{*_alloc};
+
+  auto span = ctl.reserve(16);
+  ASSERT_EQ(512, span.size());
+  EXPECT_EQ(1, _alloc->in_use());
+
+  // Encode in place
+  std::fill_n(span.begin(), 500, (std::byte)0x01);
+  ctl.commit(500);
+  EXPECT_EQ(500, ctl.size());
+
+  // Rest of the current chunk is returned, next one is allocated
+  span = ctl.reserve(16);
+  ASSERT_EQ(12, span.size());
+  EXPECT_EQ(2, _alloc->in_use());
+  std::fill(span.begin(), span.end(), (std::byte)0x02);
+  ctl.commit(span.size());
+
+  span = ctl.reserve(16);
+  ASSERT_EQ(512, span.size());
+  span[0] = (std::byte)0x03;
+  ctl.commit(1);
+  EXPECT_EQ(513, ctl.size());
+
+  std::byte copy_buf[513] {};
+  EXPECT_EQ(513, ctl.read_copy(0, copy_buf, sizeof(copy_buf)));
+  EXPECT_EQ((std::byte)0x01, copy_buf[499]);
+  EXPECT_EQ((std::byte)0x02, copy_buf[511]);
+  EXPECT_EQ((std::byte)0x03, copy_buf[512]);
+
+  // Out of chunks
+  EXPECT_TRUE(ctl.reserve(512).empty());
+  EXPECT_EQ(511, ctl.reserve(511).size());
+  ctl.commit(511);
+  EXPECT_TRUE(ctl.reserve(1).empty());
+}
+
+TEST_F(chunk_controller_test, reserve_keeps_data_in_place)
+{
+  std::byte buf[256 * 8] {};
+  ac::static_chunk_allocator allocator{buf, sizeof(buf), 256ul};
+  ac::chunk_list_wrapper ctl{allocator};
+
+  std::vector<std::byte> data(1000);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<std::byte>(i * 7);
+  ASSERT_EQ(data.size(), ctl.write(data.data(), data.size()));
+  EXPECT_EQ(240, ctl.consume(240));
+
+  std::byte * front = nullptr;
+  ASSERT_EQ(16, ctl.read(0, front, 760));
+
+  // 24 bytes are left in the last chunk, the span covering more than
+  // a chunk is allocated, but only the contiguous part is returned
+  auto span = ctl.reserve(300);
+  ASSERT_EQ(24, span.size());
+  EXPECT_EQ(6, allocator.in_use());
+  ctl.commit(span.size());
+
+  span = ctl.reserve(300);
+  ASSERT_EQ(256, span.size());
+
+  std::byte * same_front = nullptr;
+  ASSERT_EQ(16, ctl.read(0, same_front, 760));
+  EXPECT_EQ(front, same_front);
+  EXPECT_TRUE(std::equal(data.begin() + 240, data.end(), ctl.begin()));
+}
+
+// Stream over 16 chunks of 256 bytes, data is a sequence of byte values
+class chunk_data_test : public ::testing::Test
+{
+protected:
+  std::byte _buf[256 * 16] {};
+  ac::static_chunk_allocator _alloc{_buf, sizeof(_buf), 256ul};
+
+  static void fill(std::byte * buf, size_t len, size_t from)
+  {
+    for (size_t i = 0; i < len; ++i)
+      buf[i] = static_cast<std::byte>(from + i);
+  }
+
+  template<class Wrapper>
+  static bool check(Wrapper & ctl, size_t from)
+  {
+    std::vector<std::byte> data(ctl.size());
+    std::vector<std::byte> expected(ctl.size());
+    fill(expected.data(), expected.size(), from);
+    return ctl.read_copy(0, data.data(), data.size()) == data.size() && data == expected;
+  }
+};
+
+class chunk_splice_test : public chunk_data_test {};
+
+TEST_F(chunk_splice_test, append_relinks_whole_list)
+{
+  ac::chunk_list_wrapper src{_alloc};
+  ac::chunk_list_wrapper dst{_alloc};
+
+  std::byte buf[700] {};
+  fill(buf, sizeof(buf), 0);
+  ASSERT_EQ(700, src.write(buf, sizeof(buf)));
+
+  std::byte * src_ptr = nullptr;
+  EXPECT_EQ(256, src.read(0, src_ptr, 256));
+
+  EXPECT_EQ(700, dst.append(std::move(src)));
+  EXPECT_EQ(0, src.size());
+  EXPECT_EQ(700, dst.size());
+  EXPECT_EQ(3, _alloc.in_use());
+
+  // Same memory, no copy
+  std::byte * dst_ptr = nullptr;
+  EXPECT_EQ(256, dst.read(0, dst_ptr, 256));
+  EXPECT_EQ(src_ptr, dst_ptr);
+  EXPECT_TRUE(check(dst, 0));
+}
+
+TEST_F(chunk_splice_test, append_prefix_to_aligned_end)
+{
+  ac::chunk_list_wrapper src{_alloc};
+  ac::chunk_list_wrapper dst{_alloc};
+
+  std::byte buf[1000] {};
+  fill(buf, sizeof(buf), 0);
+  ASSERT_EQ(512, dst.write(buf, 512));
+  fill(buf, sizeof(buf), 512);
+  ASSERT_EQ(1000, src.write(buf, sizeof(buf)));
+  // Spare chunk at the end of dst must not break the data
+  EXPECT_FALSE(dst.reserve(16).empty());
+
+  std::byte * src_ptr = nullptr;
+  EXPECT_EQ(256, src.read(256, src_ptr, 256));
+
+  // Two whole chunks are relinked, 100 bytes are copied
+  EXPECT_EQ(612, dst.append(src, 612));
+  EXPECT_EQ(1124, dst.size());
+  EXPECT_EQ(388, src.size());
+
+  std::byte * dst_ptr = nullptr;
+  EXPECT_EQ(256, dst.read(768, dst_ptr, 256));
+  EXPECT_EQ(src_ptr, dst_ptr);
+
+  EXPECT_TRUE(check(dst, 0));
+  EXPECT_TRUE(check(src, 512 + 612));
+  // 5 chunks in dst and 2 in src
+  EXPECT_EQ(7, _alloc.in_use());
+}
+
+TEST_F(chunk_splice_test, append_with_same_offset_in_chunk)
+{
+  ac::chunk_list_wrapper src{_alloc};
+  ac::chunk_list_wrapper dst{_alloc};
+
+  std::byte buf[1000] {};
+  fill(buf, sizeof(buf), 0);
+  ASSERT_EQ(100, dst.write(buf, 100));
+  // Data in src starts at offset 100 of its first chunk as well
+  ASSERT_EQ(1000, src.write(buf, sizeof(buf)));
+  src.consume(100);
+
+  EXPECT_EQ(900, dst.append(std::move(src)));
+  EXPECT_EQ(1000, dst.size());
+  EXPECT_TRUE(check(dst, 0));
+  EXPECT_EQ(4, _alloc.in_use());
+}
+
+TEST_F(chunk_splice_test, append_unaligned_copies)
+{
+  ac::chunk_list_wrapper src{_alloc};
+  ac::chunk_list_wrapper dst{_alloc};
+
+  std::byte buf[600] {};
+  fill(buf, sizeof(buf), 0);
+  ASSERT_EQ(10, dst.write(buf, 10));
+  fill(buf, sizeof(buf), 10);
+  ASSERT_EQ(600, src.write(buf, sizeof(buf)));
+
+  EXPECT_EQ(600, dst.append(std::move(src)));
+  EXPECT_EQ(610, dst.size());
+  EXPECT_EQ(0, src.size());
+  EXPECT_TRUE(check(dst, 0));
+}
+
+using static_wrapper = ac::chunk_list_wrapper<ac::static_chunk_allocator>;
+static_assert(std::random_access_iterator<static_wrapper::iterator>);
+static_assert(std::random_access_iterator<static_wrapper::const_iterator>);
+static_assert(std::ranges::random_access_range<static_wrapper>);
+static_assert(std::ranges::random_access_range<const static_wrapper>);
+static_assert(std::random_access_iterator<static_wrapper::segment_iterator>);
+
+class chunk_iterator_test : public chunk_data_test {};
+
+TEST_F(chunk_iterator_test, byte_iterator)
+{
+  ac::chunk_list_wrapper ctl{_alloc};
+
+  std::byte buf[1000] {};
+  fill(buf, sizeof(buf), 0);
+  ASSERT_EQ(1000, ctl.write(buf, sizeof(buf)));
+  ctl.consume(100);
+
+  EXPECT_EQ(900, std::ranges::distance(ctl));
+  EXPECT_TRUE(std::ranges::equal(ctl, std::span{buf + 100, 900}));
+
+  // Pattern straddles chunks boundary
+  std::byte pattern[] = {buf[254], buf[255], buf[256], buf[257]};
+  auto found = std::ranges::search(ctl, pattern);
+  ASSERT_FALSE(found.empty());
+  EXPECT_EQ(154, found.begin() - ctl.begin());
+
+  auto it = ctl.end() - 1;
+  EXPECT_EQ(buf[999], *it);
+  EXPECT_EQ(buf[500], ctl.begin()[400]);
+  EXPECT_EQ(buf[101], *++ctl.begin());
+
+  const auto & const_ctl = ctl;
+  static_wrapper::const_iterator const_it = ctl.begin();
+  EXPECT_EQ(const_ctl.begin(), const_it);
+  EXPECT_EQ(buf[100], *const_it);
+
+  *ctl.begin() = std::byte{0xff};
+  EXPECT_EQ(std::byte{0xff}, *const_ctl.begin());
+}
+
+TEST_F(chunk_iterator_test, segments_view)
+{
+  ac::chunk_list_wrapper ctl{_alloc};
+  EXPECT_TRUE(ctl.segments().empty());
+
+  std::byte buf[1000] {};
+  fill(buf, sizeof(buf), 0);
+  ASSERT_EQ(1000, ctl.write(buf, sizeof(buf)));
+  ctl.consume(100);
+
+  auto segments = ctl.segments();
+  ASSERT_EQ(4, segments.size());
+  EXPECT_EQ(156, segments[0].size());
+  EXPECT_EQ(256, segments[1].size());
+  EXPECT_EQ(232, segments[3].size());
+  EXPECT_EQ(buf[100], segments[0][0]);
+
+  // Checksum computed block by block
+  size_t sum = 0;
+  for (auto segment : std::as_const(ctl).segments())
+    for (auto b : segment)
+      sum += static_cast<size_t>(b);
+
+  size_t expected = 0;
+  for (size_t i = 100; i < sizeof(buf); ++i)
+    expected += static_cast<size_t>(buf[i]);
+  EXPECT_EQ(expected, sum);
+}
+
+class chunk_find_test : public chunk_data_test {};
+
+TEST_F(chunk_find_test, find_byte)
+{
+  ac::chunk_list_wrapper ctl{_alloc};
+  EXPECT_EQ(ctl.npos, ctl.find(std::byte{0}));
+
+  std::byte buf[1000] {};
+  buf[10] = std::byte{0x01};
+  buf[300] = std::byte{0x01};
+  buf[999] = std::byte{0x02};
+  ASSERT_EQ(1000, ctl.write(buf, sizeof(buf)));
+
+  EXPECT_EQ(10, ctl.find(std::byte{0x01}));
+  EXPECT_EQ(300, ctl.find(std::byte{0x01}, 11));
+  EXPECT_EQ(ctl.npos, ctl.find(std::byte{0x01}, 301));
+  EXPECT_EQ(999, ctl.find(std::byte{0x02}));
+  EXPECT_EQ(ctl.npos, ctl.find(std::byte{0x03}));
+
+  // Offsets are relative to the head
+  ctl.consume(200);
+  EXPECT_EQ(100, ctl.find(std::byte{0x01}));
+}
+
+TEST_F(chunk_find_test, find_pattern)
+{
+  ac::chunk_list_wrapper ctl{_alloc};
+
+  const std::byte crlf[] = {std::byte{'\r'}, std::byte{'\n'}};
+  std::byte buf[1000] {};
+  buf[100] = std::byte{'\r'};
+  // Straddles the chunk boundary
+  buf[255] = std::byte{'\r'};
+  buf[256] = std::byte{'\n'};
+  buf[700] = std::byte{'\r'};
+  buf[701] = std::byte{'\n'};
+  buf[999] = std::byte{'\r'};
+  ASSERT_EQ(1000, ctl.write(buf, sizeof(buf)));
+
+  EXPECT_EQ(255, ctl.find(crlf));
+  EXPECT_EQ(700, ctl.find(crlf, 256));
+  // Partial match at the very end
+  EXPECT_EQ(ctl.npos, ctl.find(crlf, 701));
+
+  // Longer pattern over three chunks
+  std::vector<std::byte> pattern(buf + 250, buf + 520);
+  EXPECT_EQ(250, ctl.find(pattern));
+  EXPECT_EQ(5, ctl.find(std::span<const std::byte>{}, 5));
+}
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include "chunk_memory_resource.hpp"
+#include "static_chunk_allocator.hpp"
+#include "fixed_chunk_allocator.hpp"
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+
+// Counts requests that reach upstream
+class counting_resource : public std::pmr::memory_resource
+{
+public:
+  size_t allocations{0};
+  size_t deallocations{0};
+
+private:
+  void * do_allocate(size_t bytes, size_t alignment) override
+  {
+    ++allocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void * ptr, size_t bytes, size_t alignment) override
+  {
+    ++deallocations;
+    std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override
+  {
+    return this == &other;
+  }
+};
+
+} // namespace
+
+TEST(chunk_memory_resource_test, small_requests_take_chunks)
+{
+  alignas(std::max_align_t) std::byte buf[1024] {};
+  ac::static_chunk_allocator allocator{buf, sizeof(buf), 64};
+  counting_resource upstream;
+  ac::chunk_memory_resource resource{allocator, 64, &upstream};
+
+  // The chunk taken by the constructor went to the back of the queue
+  void * ptr = resource.allocate(64, 16);
+  EXPECT_EQ(buf + 64, ptr);
+  EXPECT_EQ(1, allocator.in_use());
+
+  void * big = resource.allocate(65);
+  void * over_aligned = resource.allocate(16, 2 * alignof(std::max_align_t));
+  EXPECT_EQ(2, upstream.allocations);
+  EXPECT_EQ(1, allocator.in_use());
+
+  resource.deallocate(over_aligned, 16, 2 * alignof(std::max_align_t));
+  resource.deallocate(big, 65);
+  resource.deallocate(ptr, 64, 16);
+  EXPECT_EQ(2, upstream.deallocations);
+  EXPECT_EQ(0, allocator.in_use());
+}
+
+TEST(chunk_memory_resource_test, out_of_chunks)
+{
+  ac::fixed_chunk_allocator<64, 2> allocator;
+  ac::chunk_memory_resource resource{allocator};
+  EXPECT_EQ(64, resource.chunk_size());
+
+  void * ptr1 = resource.allocate(8);
+  void * ptr2 = resource.allocate(8);
+  EXPECT_THROW((void)resource.allocate(8), std::bad_alloc);
+
+  resource.deallocate(ptr1, 8);
+  resource.deallocate(ptr2, 8);
+  EXPECT_EQ(2, allocator.remain());
+}
+
+TEST(chunk_memory_resource_test, chunk_size_from_allocator)
+{
+  alignas(std::max_align_t) std::byte buf[256] {};
+  ac::static_chunk_allocator allocator{buf, sizeof(buf), 64};
+  counting_resource upstream;
+  ac::chunk_memory_resource resource{allocator, 128, &upstream};
+  EXPECT_EQ(64, resource.chunk_size());
+  EXPECT_EQ(0, allocator.in_use());
+
+  // Bigger than a chunk, so it goes upstream
+  void * big = resource.allocate(100);
+  EXPECT_EQ(1, upstream.allocations);
+  EXPECT_EQ(0, allocator.in_use());
+
+  void * ptr = resource.allocate(32);
+  EXPECT_EQ(1, allocator.in_use());
+  resource.deallocate(ptr, 32);
+  resource.deallocate(big, 100);
+  EXPECT_EQ(0, allocator.in_use());
+  EXPECT_EQ(1, upstream.deallocations);
+
+  ac::fixed_chunk_allocator<64, 2> fixed;
+  ac::chunk_memory_resource fixed_resource{fixed, 128, &upstream};
+  EXPECT_EQ(64, fixed_resource.chunk_size());
+
+  // No free chunk to learn the size from
+  ac::static_chunk_allocator empty{buf, 0, 64};
+  ac::chunk_memory_resource empty_resource{empty, 64, &upstream};
+  EXPECT_EQ(0, empty_resource.chunk_size());
+  empty_resource.deallocate(empty_resource.allocate(8), 8);
+  EXPECT_EQ(2, upstream.allocations);
+}
+
+TEST(chunk_memory_resource_test, pmr_containers)
+{
+  ac::fixed_chunk_allocator<64, 256> allocator;
+  counting_resource upstream;
+  ac::chunk_memory_resource resource{allocator, &upstream};
+
+  {
+    std::pmr::list<int> list{&resource};
+    for (int i = 0; i < 100; ++i)
+      list.push_back(i);
+    EXPECT_EQ(100, allocator.in_use());
+    EXPECT_EQ(0, upstream.allocations);
+
+    std::pmr::vector<int> vec{&resource};
+    vec.resize(1000);
+    EXPECT_EQ(1, upstream.allocations);
+  }
+  EXPECT_EQ(0, allocator.in_use());
+}
+
+TEST(chunk_stl_allocator_test, node_containers)
+{
+  using allocator_type = ac::fixed_chunk_allocator<64, 512>;
+  allocator_type allocator;
+  counting_resource upstream;
+  ac::chunk_memory_resource resource{allocator, &upstream};
+
+  {
+    std::map<int, int, std::less<int>, ac::chunk_stl_allocator<std::pair<const int, int>, allocator_type>> map{resource};
+    for (int i = 0; i < 100; ++i)
+      map.emplace(i, i * 2);
+    EXPECT_EQ(100, allocator.in_use());
+    map.erase(map.begin(), map.find(50));
+    EXPECT_EQ(50, allocator.in_use());
+    EXPECT_EQ(100, map.at(50));
+  }
+  EXPECT_EQ(0, allocator.in_use());
+
+  {
+    using value_type = std::pair<const int, int>;
+    std::unordered_map<int, int, std::hash<int>, std::equal_to<int>,
+                       ac::chunk_stl_allocator<value_type, allocator_type>> map{16, resource};
+    for (int i = 0; i < 100; ++i)
+      map.emplace(i, i);
+    EXPECT_EQ(100, map.size());
+    // Bucket arrays don't fit chunks
+    EXPECT_LT(0, upstream.allocations);
+  }
+  EXPECT_EQ(0, allocator.in_use());
+  EXPECT_EQ(upstream.allocations, upstream.deallocations);
+}
+
+TEST(chunk_stl_allocator_test, rebind_equality)
+{
+  ac::fixed_chunk_allocator<64, 4> allocator;
+  ac::chunk_memory_resource resource{allocator};
+  ac::fixed_chunk_allocator<64, 4> other_allocator;
+  ac::chunk_memory_resource other_resource{other_allocator};
+
+  ac::chunk_stl_allocator<int, ac::fixed_chunk_allocator<64, 4>> ints{resource};
+  ac::chunk_stl_allocator<double, ac::fixed_chunk_allocator<64, 4>> doubles{ints};
+  ac::chunk_stl_allocator<int, ac::fixed_chunk_allocator<64, 4>> others{other_resource};
+  EXPECT_TRUE(ints == doubles);
+  EXPECT_TRUE(ints != others);
+
+  double * ptr = doubles.allocate(8);
+  EXPECT_EQ(1, allocator.in_use());
+  doubles.deallocate(ptr, 8);
+  EXPECT_EQ(0, allocator.in_use());
+}
@@ -105,3 +105,66 @@ TEST(dumb_chunk_allocator_test, dealloc_wrong_chunk)
   EXPECT_EQ(1, alloc.in_use());
   EXPECT_EQ(0, alloc.remain());
 }
+
+TEST(dumb_chunk_allocator_test, batch_allocs_and_deallocs)
+{
+  ac::dumb_chunk_allocator alloc{16, 10};
+
+  auto first = alloc.allocate();
+  alloc.deallocate(first);
+
+  ac::dumb_chunk_allocator::chunk_type chunks[20];
+  size_t count = alloc.allocate_n(chunks);
+  EXPECT_EQ(10, count);
+  EXPECT_EQ(10, alloc.size());
+  EXPECT_EQ(10, alloc.in_use());
+  // Free chunks are reused before allocating new ones
+  EXPECT_EQ(first.data(), chunks[0].data());
+
+  alloc.deallocate_n(std::span{chunks, count});
+  EXPECT_EQ(0, alloc.in_use());
+  EXPECT_EQ(10, alloc.remain());
+}
+
+TEST(dumb_chunk_allocator_test, slab_growth)
+{
+  ac::dumb_chunk_allocator alloc{16, 100, {.first_slab_chunks = 4,
+                                           .growth_factor = 2,
+                                           .max_slab_chunks = 8}};
+
+  ac::dumb_chunk_allocator::chunk_type chunks[100];
+  for (auto & it : chunks)
+  {
+    it = alloc.allocate();
+    ASSERT_FALSE(it.empty());
+  }
+  EXPECT_TRUE(alloc.allocate().empty());
+
+  // Chunks of the first slab are adjacent
+  EXPECT_EQ(chunks[0].data() + 16, chunks[1].data());
+  EXPECT_EQ(chunks[0].data() + 48, chunks[3].data());
+
+  for (auto & it : chunks)
+    alloc.deallocate(it);
+
+  EXPECT_EQ(100, alloc.size());
+  EXPECT_EQ(0, alloc.in_use());
+  EXPECT_EQ(100, alloc.remain());
+}
+
+TEST(dumb_chunk_allocator_test, dealloc_uncarved_chunk)
+{
+  ac::dumb_chunk_allocator alloc{16, 10, {.first_slab_chunks = 4}};
+
+  auto chunk = alloc.allocate();
+  EXPECT_EQ(1, alloc.in_use());
+
+  // Next chunk in the slab is not handed out yet
+  alloc.deallocate({chunk.data() + 16, 16});
+  EXPECT_EQ(1, alloc.in_use());
+  EXPECT_EQ(9, alloc.remain());
+
+  alloc.deallocate(chunk);
+  EXPECT_EQ(0, alloc.in_use());
+  EXPECT_EQ(10, alloc.remain());
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include "fixed_chunk_allocator.hpp"
+#include "chunk_list_wrapper.hpp"
+#include <vector>
+
+static_assert(ac::HasStaticChunkSize<ac::fixed_chunk_allocator<512, 2>>);
+static_assert(!ac::HasStaticChunkSize<ac::static_chunk_allocator>);
+
+namespace
+{
+
+constinit ac::fixed_chunk_allocator<64, 4> static_allocator;
+
+constexpr size_t remain_after_churn()
+{
+  ac::fixed_chunk_allocator<16, 4> allocator;
+  auto chunk1 = allocator.allocate();
+  auto chunk2 = allocator.allocate();
+  allocator.deallocate(chunk1);
+  (void)chunk2;
+  return allocator.remain();
+}
+
+static_assert(remain_after_churn() == 3);
+
+} // namespace
+
+TEST(fixed_chunk_allocator_test, single_allocation)
+{
+  ac::fixed_chunk_allocator<512, 2> allocator;
+
+  ASSERT_EQ(2, allocator.size());
+
+  auto chunk = allocator.allocate();
+  EXPECT_EQ(512, chunk.size());
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(chunk.data()) % alignof(std::max_align_t));
+  EXPECT_EQ(1, allocator.in_use());
+  EXPECT_EQ(1, allocator.remain());
+}
+
+TEST(fixed_chunk_allocator_test, all_mem_exceed)
+{
+  ac::fixed_chunk_allocator<1024, 1> allocator;
+
+  auto chunk1 = allocator.allocate();
+  auto chunk2 = allocator.allocate();
+  EXPECT_EQ(1024, chunk1.size());
+  EXPECT_EQ(1, allocator.in_use());
+  EXPECT_EQ(0, allocator.remain());
+  EXPECT_TRUE(chunk2.empty());
+}
+
+TEST(fixed_chunk_allocator_test, chunks_are_consecutive)
+{
+  ac::fixed_chunk_allocator<48, 8, 16> allocator;
+
+  auto first = allocator.allocate();
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(first.data()) % 16);
+  for (size_t i = 1; i < 8; ++i)
+    EXPECT_EQ(first.data() + 48 * i, allocator.allocate().data());
+  EXPECT_TRUE(allocator.allocate().empty());
+}
+
+TEST(fixed_chunk_allocator_test, freed_chunks_reused_lifo)
+{
+  ac::fixed_chunk_allocator<16, 4> allocator;
+
+  auto chunk1 = allocator.allocate();
+  auto chunk2 = allocator.allocate();
+  allocator.deallocate(chunk1);
+  allocator.deallocate(chunk2);
+
+  EXPECT_EQ(chunk2.data(), allocator.allocate().data());
+  EXPECT_EQ(chunk1.data(), allocator.allocate().data());
+}
+
+TEST(fixed_chunk_allocator_test, dealloc_foreign_chunk)
+{
+  ac::fixed_chunk_allocator<16, 4> allocator;
+  auto chunk = allocator.allocate();
+
+  std::byte foreign[16] {};
+  allocator.deallocate(std::span{foreign});
+  allocator.deallocate(chunk.subspan(1));
+  EXPECT_EQ(1, allocator.in_use());
+
+  allocator.deallocate(chunk);
+  EXPECT_EQ(0, allocator.in_use());
+}
+
+TEST(fixed_chunk_allocator_test, batch)
+{
+  ac::fixed_chunk_allocator<16, 4> allocator;
+
+  ac::fixed_chunk_allocator<16, 4>::chunk_type chunks[6];
+  EXPECT_EQ(4, allocator.allocate_n(chunks));
+  EXPECT_EQ(0, allocator.remain());
+
+  allocator.deallocate_n(std::span{chunks, 4});
+  EXPECT_EQ(4, allocator.remain());
+}
+
+TEST(fixed_chunk_allocator_test, static_storage)
+{
+  auto chunk = static_allocator.allocate();
+  EXPECT_EQ(64, chunk.size());
+  EXPECT_EQ(3, static_allocator.remain());
+  static_allocator.deallocate(chunk);
+  EXPECT_EQ(4, static_allocator.remain());
+}
+
+TEST(fixed_chunk_allocator_test, chunk_list_wrapper)
+{
+  ac::fixed_chunk_allocator<256, 16> allocator;
+  ac::chunk_list_wrapper ctl{allocator};
+
+  std::vector<std::byte> data(1000);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<std::byte>(i * 7);
+
+  ASSERT_EQ(data.size(), ctl.write(data.data(), data.size()));
+  EXPECT_EQ(4, allocator.in_use());
+
+  ctl.consume(300);
+  EXPECT_EQ(3, allocator.in_use());
+
+  std::vector<std::byte> out(700);
+  ASSERT_EQ(out.size(), ctl.read_copy(0, out.data(), out.size()));
+  EXPECT_TRUE(std::equal(out.begin(), out.end(), data.begin() + 300));
+  EXPECT_EQ(data[555], ctl.begin()[255]);
+}
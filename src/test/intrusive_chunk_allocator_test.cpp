@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include "intrusive_chunk_allocator.hpp"
+
+TEST(intrusive_chunk_allocator_test, single_allocation)
+{
+  std::byte buf[1024] {};
+  ac::intrusive_chunk_allocator allocator{buf, sizeof(buf), 512};
+
+  ASSERT_EQ(2, allocator.size());
+
+  auto chunk = allocator.allocate();
+  EXPECT_EQ(512, chunk.size());
+  EXPECT_EQ(buf, chunk.data());
+  EXPECT_EQ(1, allocator.in_use());
+  EXPECT_EQ(1, allocator.remain());
+}
+
+TEST(intrusive_chunk_allocator_test, all_mem_exceed)
+{
+  std::byte buf[1024] {};
+  ac::intrusive_chunk_allocator allocator{buf, sizeof(buf), 1024};
+
+  auto chunk1 = allocator.allocate();
+  auto chunk2 = allocator.allocate();
+  EXPECT_EQ(1024, chunk1.size());
+  EXPECT_EQ(1, allocator.in_use());
+  EXPECT_EQ(0, allocator.remain());
+  EXPECT_TRUE(chunk2.empty());
+}
+
+TEST(intrusive_chunk_allocator_test, freed_chunks_reused_lifo)
+{
+  std::byte buf[1024] {};
+  ac::intrusive_chunk_allocator allocator{buf, sizeof(buf), 16};
+
+  ASSERT_EQ(64, allocator.size());
+
+  ac::intrusive_chunk_allocator::chunk_type chunks[64];
+  for (auto & chunk : chunks)
+  {
+    chunk = allocator.allocate();
+    EXPECT_EQ(16, chunk.size());
+  }
+
+  EXPECT_EQ(64, allocator.in_use());
+  EXPECT_EQ(0, allocator.remain());
+  EXPECT_TRUE(allocator.allocate().empty());
+
+  for (auto & chunk : chunks)
+    allocator.deallocate(chunk);
+
+  EXPECT_EQ(0, allocator.in_use());
+  EXPECT_EQ(64, allocator.remain());
+
+  // Last freed chunk goes out first
+  for (size_t i = 64; i > 0; --i)
+    EXPECT_EQ(chunks[i - 1].data(), allocator.allocate().data());
+
+  EXPECT_EQ(64, allocator.in_use());
+  EXPECT_EQ(0, allocator.remain());
+}
+
+TEST(intrusive_chunk_allocator_test, free_list_mixed_with_untouched)
+{
+  std::byte buf[64] {};
+  ac::intrusive_chunk_allocator allocator{buf, sizeof(buf), 16};
+
+  auto chunk1 = allocator.allocate();
+  auto chunk2 = allocator.allocate();
+  allocator.deallocate(chunk1);
+
+  // Freed chunk is preferred over the untouched ones
+  EXPECT_EQ(chunk1.data(), allocator.allocate().data());
+  EXPECT_EQ(buf + 32, allocator.allocate().data());
+  EXPECT_EQ(buf + 48, allocator.allocate().data());
+  EXPECT_TRUE(allocator.allocate().empty());
+
+  allocator.deallocate(chunk2);
+  EXPECT_EQ(1, allocator.remain());
+  EXPECT_EQ(chunk2.data(), allocator.allocate().data());
+}
+
+TEST(intrusive_chunk_allocator_test, deallocate_wrong_pointer)
+{
+  std::byte buf[1024] {};
+  ac::intrusive_chunk_allocator allocator{buf, sizeof(buf), 512};
+
+  auto chunk = allocator.allocate();
+
+  allocator.deallocate(chunk.subspan(1));
+  EXPECT_EQ(1, allocator.in_use());
+
+  // Chunk above high-water mark was never handed out
+  allocator.deallocate({buf + 512, 512});
+  EXPECT_EQ(1, allocator.in_use());
+
+  allocator.deallocate(chunk);
+  EXPECT_EQ(0, allocator.in_use());
+  EXPECT_EQ(2, allocator.remain());
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include "lockfree_chunk_allocator.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST(lockfree_chunk_allocator_test, single_allocation)
+{
+  std::byte buf[1024] {};
+  ac::lockfree_chunk_allocator allocator{buf, sizeof(buf), 512};
+
+  ASSERT_EQ(2, allocator.size());
+
+  auto chunk = allocator.allocate();
+  EXPECT_EQ(512, chunk.size());
+  EXPECT_EQ(1, allocator.in_use());
+  EXPECT_EQ(1, allocator.remain());
+}
+
+TEST(lockfree_chunk_allocator_test, all_mem_exceed)
+{
+  std::byte buf[1024] {};
+  ac::lockfree_chunk_allocator allocator{buf, sizeof(buf), 1024};
+
+  auto chunk1 = allocator.allocate();
+  auto chunk2 = allocator.allocate();
+  EXPECT_EQ(1024, chunk1.size());
+  EXPECT_EQ(0, allocator.remain());
+  EXPECT_TRUE(chunk2.empty());
+
+  allocator.deallocate(chunk1);
+  EXPECT_EQ(1, allocator.remain());
+  EXPECT_EQ(chunk1.data(), allocator.allocate().data());
+}
+
+TEST(lockfree_chunk_allocator_test, deallocate_wrong_pointer)
+{
+  std::byte buf[1024] {};
+  ac::lockfree_chunk_allocator allocator{buf, sizeof(buf), 1024};
+
+  auto chunk = allocator.allocate();
+
+  allocator.deallocate(chunk.subspan(1));
+  allocator.deallocate(ac::lockfree_chunk_allocator::chunk_type{});
+  EXPECT_EQ(1, allocator.in_use());
+
+  allocator.deallocate(chunk);
+  EXPECT_EQ(0, allocator.in_use());
+}
+
+TEST(lockfree_chunk_allocator_test, concurrent_allocs_and_deallocs)
+{
+  constexpr size_t chunk_size = 16;
+  constexpr size_t threads_count = 8;
+  constexpr size_t chunks_per_thread = 32;
+  static std::byte buf[chunk_size * threads_count * chunks_per_thread] {};
+  ac::lockfree_chunk_allocator allocator{buf, sizeof(buf), chunk_size};
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < threads_count; ++t)
+  {
+    threads.emplace_back([&allocator, t]
+    {
+      ac::lockfree_chunk_allocator::chunk_type chunks[chunks_per_thread];
+      for (int round = 0; round < 1000; ++round)
+      {
+        for (auto & chunk : chunks)
+        {
+          chunk = allocator.allocate();
+          ASSERT_FALSE(chunk.empty());
+          // Nobody else may own the chunk at the same time
+          std::fill(chunk.begin(), chunk.end(), static_cast<std::byte>(t));
+        }
+        for (auto & chunk : chunks)
+        {
+          for (auto b : chunk)
+            ASSERT_EQ(static_cast<std::byte>(t), b);
+          allocator.deallocate(chunk);
+        }
+      }
+    });
+  }
+  for (auto & it : threads)
+    it.join();
+
+  EXPECT_EQ(0, allocator.in_use());
+  EXPECT_EQ(allocator.size(), allocator.remain());
+}
+
+TEST(lockfree_chunk_allocator_test, counters_stay_in_range)
+{
+  static std::byte buf[16 * 4] {};
+  ac::lockfree_chunk_allocator allocator{buf, sizeof(buf), 16};
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([&allocator]
+    {
+      for (int round = 0; round < 100000; ++round)
+      {
+        auto chunk = allocator.allocate();
+        if (chunk.empty() == false)
+          allocator.deallocate(chunk);
+      }
+    });
+  }
+  std::thread observer([&]
+  {
+    while (done.load(std::memory_order_relaxed) == false)
+    {
+      ASSERT_LE(allocator.in_use(), allocator.size());
+      ASSERT_LE(allocator.remain(), allocator.size());
+    }
+  });
+
+  for (auto & it : threads)
+    it.join();
+  done.store(true, std::memory_order_relaxed);
+  observer.join();
+  EXPECT_EQ(allocator.size(), allocator.remain());
+}
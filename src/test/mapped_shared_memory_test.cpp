@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#ifdef __linux__
+
+#include "mapped_shared_memory.hpp"
+#include "process_shared_chunk_allocator.hpp"
+#include "shared_ring.hpp"
+#include <cstring>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+
+std::string test_name(const char * suffix)
+{
+  return "/ac_test_" + std::to_string(::getpid()) + "_" + suffix;
+}
+
+} // namespace
+
+TEST(mapped_shared_memory_test, posix_create_and_open)
+{
+  const auto name = test_name("posix");
+  ac::posix_shared_memory owner{name, 1 << 16};
+  ASSERT_TRUE(owner.create());
+  EXPECT_FALSE(ac::posix_shared_memory(name, 1 << 16).create());
+
+  ac::posix_shared_memory other{name, 0};
+  ASSERT_TRUE(other.open());
+  EXPECT_EQ(owner.size(), other.size());
+  ASSERT_NE(owner.get_base_pointer().value(), other.get_base_pointer().value());
+
+  ac::process_shared_chunk_allocator first{owner, 1024};
+  ac::process_shared_chunk_allocator second{other, 1024};
+  auto chunk = first.allocate();
+  ASSERT_FALSE(chunk.empty());
+  ::strcpy(reinterpret_cast<char *>(chunk.data()), "posix");
+
+  auto seen = second.from_handle(first.to_handle(chunk));
+  EXPECT_STREQ("posix", reinterpret_cast<const char *>(seen.data()));
+  second.deallocate(seen);
+  EXPECT_EQ(first.size(), first.remain());
+}
+
+TEST(mapped_shared_memory_test, posix_owner_unlinks)
+{
+  const auto name = test_name("unlink");
+  {
+    ac::posix_shared_memory owner{name, 4096, {ac::huge_pages::transparent, true}};
+    ASSERT_TRUE(owner.create_or_open());
+  }
+  ac::posix_shared_memory other{name, 0};
+  EXPECT_FALSE(other.open());
+  EXPECT_FALSE(other.get_base_pointer().has_value());
+}
+
+TEST(mapped_shared_memory_test, posix_rejects_explicit_huge_pages)
+{
+  ac::posix_shared_memory segment{test_name("huge"), 1 << 21, {ac::huge_pages::explicit_2mb}};
+  EXPECT_FALSE(segment.create());
+}
+
+TEST(mapped_shared_memory_test, memfd_passed_over_socket)
+{
+  ac::memfd_shared_memory segment{"ac_test", 1 << 16};
+  ASSERT_TRUE(segment.create());
+  ac::spsc_ring ring{segment};
+
+  int sockets[2];
+  ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+
+  pid_t pid = ::fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0)
+  {
+    ::close(sockets[0]);
+    ac::memfd_shared_memory child{"ac_test", 0};
+    if (child.open(ac::receive_fd(sockets[1])) == false)
+      ::_exit(1);
+
+    // Different mapping of the same memory
+    ac::spsc_ring child_ring{child};
+    const char message[] = "memfd";
+    ::_exit(child_ring.try_push(std::as_bytes(std::span{message})) ? 0 : 2);
+  }
+
+  ::close(sockets[1]);
+  ASSERT_TRUE(ac::send_fd(sockets[0], segment.fd()));
+  ::close(sockets[0]);
+
+  int status = 0;
+  ASSERT_EQ(pid, ::waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+
+  auto message = ring.front();
+  ASSERT_NE(nullptr, message.data());
+  EXPECT_STREQ("memfd", reinterpret_cast<const char *>(message.data()));
+}
+
+TEST(mapped_shared_memory_test, memfd_explicit_huge_pages)
+{
+  ac::memfd_shared_memory segment{"ac_test_huge", 4096, {ac::huge_pages::explicit_2mb}};
+  EXPECT_EQ(size_t{2} << 20, segment.size());
+  if (segment.create() == false)
+    GTEST_SKIP() << "No reserved 2MB huge pages";
+
+  ac::process_shared_chunk_allocator allocator{segment, 4096};
+  EXPECT_LT(0, allocator.size());
+}
+
+#endif // __linux__
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include "monotonic_arena.hpp"
+#include "static_chunk_allocator.hpp"
+
+namespace
+{
+
+struct point
+{
+  int x;
+  int y;
+};
+
+} // namespace
+
+TEST(monotonic_arena_test, bump_in_one_chunk)
+{
+  alignas(std::max_align_t) std::byte buf[1024] {};
+  ac::static_chunk_allocator allocator{buf, sizeof(buf), 256};
+  ac::monotonic_arena arena{allocator};
+
+  auto * first = static_cast<std::byte *>(arena.allocate(10, 1));
+  auto * second = static_cast<std::byte *>(arena.allocate(10, 1));
+  EXPECT_EQ(buf, first);
+  EXPECT_EQ(first + 10, second);
+  EXPECT_EQ(1, allocator.in_use());
+  EXPECT_EQ(1, arena.chunks_count());
+}
+
+TEST(monotonic_arena_test, alignment)
+{
+  alignas(std::max_align_t) std::byte buf[1024] {};
+  ac::static_chunk_allocator allocator{buf, sizeof(buf), 256};
+  ac::monotonic_arena arena{allocator};
+
+  (void)arena.allocate(1, 1);
+  void * ptr = arena.allocate(8, 64);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptr) % 64);
+
+  auto * p = arena.create<point>(1, 2);
+  ASSERT_NE(nullptr, p);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p) % alignof(point));
+  EXPECT_EQ(1, p->x);
+  EXPECT_EQ(2, p->y);
+}
+
+TEST(monotonic_arena_test, next_chunk_and_exhaustion)
+{
+  alignas(std::max_align_t) std::byte buf[512] {};
+  ac::static_chunk_allocator allocator{buf, sizeof(buf), 256};
+  ac::monotonic_arena arena{allocator};
+
+  EXPECT_NE(nullptr, arena.allocate(200));
+  EXPECT_NE(nullptr, arena.allocate(200));
+  EXPECT_EQ(2, allocator.in_use());
+  EXPECT_EQ(nullptr, arena.allocate(200));
+  // Bigger than a chunk
+  EXPECT_EQ(nullptr, arena.allocate(257));
+  EXPECT_NE(nullptr, arena.allocate(56, 1));
+}
+
+TEST(monotonic_arena_test, nested_rewind)
+{
+  alignas(std::max_align_t) std::byte buf[1024] {};
+  ac::static_chunk_allocator allocator{buf, sizeof(buf), 256};
+  ac::monotonic_arena arena{allocator};
+
+  void * base = arena.allocate(100);
+  auto outer = arena.mark();
+  void * first = arena.allocate(200);
+
+  auto inner = arena.mark();
+  void * second = arena.allocate(200);
+  EXPECT_EQ(3, arena.chunks_count());
+
+  arena.rewind(inner);
+  EXPECT_EQ(second, arena.allocate(200));
+
+  arena.rewind(outer);
+  EXPECT_EQ(first, arena.allocate(200));
+  EXPECT_NE(base, first);
+
+  // Chunks are kept until reset()
+  EXPECT_EQ(3, allocator.in_use());
+  arena.reset();
+  EXPECT_EQ(0, allocator.in_use());
+  EXPECT_EQ(0, arena.chunks_count());
+}
+
+TEST(monotonic_arena_test, destructor_returns_chunks)
+{
+  alignas(std::max_align_t) std::byte buf[1024] {};
+  ac::static_chunk_allocator allocator{buf, sizeof(buf), 256};
+  {
+    ac::monotonic_arena arena{allocator};
+    for (int i = 0; i < 100; ++i)
+      ASSERT_NE(nullptr, arena.create<point>(i, i));
+    EXPECT_EQ(4, allocator.in_use());
+  }
+  EXPECT_EQ(0, allocator.in_use());
+}
+
+TEST(monotonic_arena_test, unfit_requests_keep_no_chunks)
+{
+  alignas(std::max_align_t) std::byte buf[1024] {};
+  ac::static_chunk_allocator allocator{buf, sizeof(buf), 256};
+  ac::monotonic_arena arena{allocator};
+
+  // Chunk size isn't known yet, the taken chunk is given back
+  EXPECT_EQ(nullptr, arena.allocate(300, 1));
+  EXPECT_EQ(0, arena.chunks_count());
+  EXPECT_EQ(0, allocator.in_use());
+
+  EXPECT_NE(nullptr, arena.allocate(200, 1));
+  for (int i = 0; i < 3; ++i)
+    EXPECT_EQ(nullptr, arena.allocate(200, 512));
+  EXPECT_EQ(nullptr, arena.allocate(257, 1));
+  EXPECT_EQ(1, arena.chunks_count());
+  EXPECT_EQ(1, allocator.in_use());
+
+  EXPECT_NE(nullptr, arena.allocate(56, 1));
+  EXPECT_EQ(1, arena.chunks_count());
+  EXPECT_NE(nullptr, arena.allocate(256, alignof(std::max_align_t)));
+  EXPECT_EQ(2, arena.chunks_count());
+}
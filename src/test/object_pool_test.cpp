@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include "object_pool.hpp"
+#include "static_chunk_allocator.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct session
+{
+  session(int id, std::string name) :
+    id(id), name(std::move(name))
+  {
+    ++alive;
+  }
+
+  ~session()
+  {
+    --alive;
+  }
+
+  int id;
+  std::string name;
+
+  static inline int alive = 0;
+};
+
+struct alignas(64) aligned_item
+{
+  char data[8];
+};
+
+struct throwing_item
+{
+  throwing_item()
+  {
+    throw std::runtime_error{"ctor"};
+  }
+};
+
+} // namespace
+
+TEST(object_pool_test, create_destroy)
+{
+  alignas(std::max_align_t) std::byte buf[1024] {};
+  ac::static_chunk_allocator allocator{buf, sizeof(buf), 512};
+  ac::object_pool<session, ac::static_chunk_allocator> pool{allocator};
+
+  session * s = pool.create(1, "first");
+  ASSERT_NE(nullptr, s);
+  EXPECT_EQ(1, s->id);
+  EXPECT_EQ("first", s->name);
+  EXPECT_EQ(1, session::alive);
+  EXPECT_EQ(1, pool.in_use());
+  EXPECT_EQ(1, allocator.in_use());
+
+  pool.destroy(s);
+  EXPECT_EQ(0, session::alive);
+  EXPECT_EQ(0, pool.in_use());
+
+  // Freed slot is reused
+  EXPECT_EQ(s, pool.create(2, "second"));
+  pool.destroy(s);
+}
+
+TEST(object_pool_test, packs_objects_per_chunk)
+{
+  alignas(std::max_align_t) std::byte buf[1024] {};
+  ac::static_chunk_allocator allocator{buf, sizeof(buf), 512};
+  using pool_type = ac::object_pool<session, ac::static_chunk_allocator>;
+  pool_type pool{allocator};
+
+  const size_t per_chunk = 512 / pool_type::slot_size;
+  std::vector<session *> sessions;
+  for (size_t i = 0; i < 2 * per_chunk; ++i)
+    sessions.push_back(pool.create(static_cast<int>(i), "s"));
+  EXPECT_EQ(2, allocator.in_use());
+  EXPECT_EQ(nullptr, pool.create(0, "none"));
+
+  for (auto * it : sessions)
+    pool.destroy(it);
+  EXPECT_EQ(0, session::alive);
+}
+
+TEST(object_pool_test, alignment)
+{
+  std::byte buf[1024 + 8] {};
+  // Chunks are deliberately misaligned
+  ac::static_chunk_allocator allocator{buf + 8, 1024, 256};
+  ac::object_pool<aligned_item, ac::static_chunk_allocator> pool{allocator};
+
+  for (int i = 0; i < 6; ++i)
+  {
+    auto * item = pool.create();
+    ASSERT_NE(nullptr, item);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(item) % 64);
+  }
+}
+
+TEST(object_pool_test, handle)
+{
+  alignas(std::max_align_t) std::byte buf[1024] {};
+  ac::static_chunk_allocator allocator{buf, sizeof(buf), 512};
+  ac::object_pool<session, ac::static_chunk_allocator> pool{allocator};
+
+  {
+    auto handle = pool.make(7, "handle");
+    ASSERT_TRUE(handle);
+    EXPECT_EQ(7, handle->id);
+    EXPECT_EQ(1, pool.in_use());
+  }
+  EXPECT_EQ(0, pool.in_use());
+  EXPECT_EQ(0, session::alive);
+}
+
+TEST(object_pool_test, throwing_constructor)
+{
+  alignas(std::max_align_t) std::byte buf[1024] {};
+  ac::static_chunk_allocator allocator{buf, sizeof(buf), 512};
+  ac::object_pool<throwing_item, ac::static_chunk_allocator> pool{allocator};
+
+  EXPECT_THROW((void)pool.create(), std::runtime_error);
+  EXPECT_EQ(0, pool.in_use());
+}
+
+TEST(object_pool_test, chunks_returned_with_pool)
+{
+  alignas(std::max_align_t) std::byte buf[1024] {};
+  ac::static_chunk_allocator allocator{buf, sizeof(buf), 512};
+  {
+    ac::object_pool<int, ac::static_chunk_allocator> pool{allocator};
+    for (int i = 0; i < 200; ++i)
+      pool.destroy(pool.create(i));
+    EXPECT_EQ(1, allocator.in_use());
+  }
+  EXPECT_EQ(0, allocator.in_use());
+}
@@ -0,0 +1,261 @@
+#include <gtest/gtest.h>
+#include "persistent_chunk_pool.hpp"
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include "mapped_shared_memory.hpp"
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+using list_type = ac::persistent_chunk_list;
+
+constexpr size_t segment_size = 1 << 16;
+constexpr size_t chunk_size = 256;
+constexpr size_t lists_count = 4;
+
+// Zero-filled and aligned like a new shared memory segment
+struct segment_holder
+{
+  alignas(64) std::byte data[segment_size] {};
+};
+
+void write_text(list_type & list, const std::string & text)
+{
+  ASSERT_EQ(text.size(), list.write(reinterpret_cast<const std::byte *>(text.data()), text.size()));
+}
+
+std::string read_text(list_type & list)
+{
+  std::string ret(list.size(), '\0');
+  EXPECT_EQ(ret.size(), list.read_copy(0, reinterpret_cast<std::byte *>(ret.data()), ret.size()));
+  return ret;
+}
+
+std::string make_text(size_t len)
+{
+  std::string ret;
+  for (size_t i = 0; i < len; ++i)
+    ret.push_back(static_cast<char>('a' + i % 26));
+  return ret;
+}
+
+} // namespace
+
+TEST(persistent_chunk_pool_test, store_and_load_after_restart)
+{
+  auto segment = std::make_unique<segment_holder>();
+  const auto text = make_text(1000);
+  size_t stored_chunks = 0;
+  {
+    ac::persistent_chunk_pool pool{segment->data, segment_size, chunk_size, lists_count};
+    EXPECT_EQ(ac::pool_attach::formatted, pool.attach_status());
+    ASSERT_LT(0, pool.size());
+
+    list_type list{pool};
+    write_text(list, "xyz" + text);
+    EXPECT_EQ(3, list.consume(3));
+    stored_chunks = list.chunks_count();
+    ASSERT_TRUE(pool.store(1, list));
+    EXPECT_EQ(0, list.size());
+    EXPECT_TRUE(pool.stored(1));
+    EXPECT_EQ(text.size(), pool.stored_size(1));
+    EXPECT_FALSE(pool.store(1, list));
+  }
+
+  ac::persistent_chunk_pool pool{segment->data, segment_size, chunk_size, lists_count};
+  EXPECT_EQ(ac::pool_attach::reattached, pool.attach_status());
+  EXPECT_EQ(2, pool.generation());
+  EXPECT_EQ(stored_chunks, pool.in_use());
+
+  list_type list{pool};
+  EXPECT_FALSE(pool.load(0, list));
+  ASSERT_TRUE(pool.load(1, list));
+  EXPECT_FALSE(pool.stored(1));
+  EXPECT_EQ(text, read_text(list));
+
+  list.clear();
+  EXPECT_EQ(pool.size(), pool.remain());
+}
+
+TEST(persistent_chunk_pool_test, recovery_frees_loose_chunks)
+{
+  auto segment = std::make_unique<segment_holder>();
+  auto crashed = std::make_unique<segment_holder>();
+  {
+    ac::persistent_chunk_pool pool{segment->data, segment_size, chunk_size, lists_count};
+    list_type stored{pool};
+    write_text(stored, make_text(600));
+    ASSERT_TRUE(pool.store(2, stored));
+
+    list_type loose{pool};
+    write_text(loose, make_text(2000));
+    // Memory as the process left it at crash
+    ::memcpy(crashed->data, segment->data, segment_size);
+  }
+
+  ac::persistent_chunk_pool pool{crashed->data, segment_size, chunk_size, lists_count};
+  EXPECT_EQ(ac::pool_attach::recovered, pool.attach_status());
+  EXPECT_EQ(3, pool.in_use());
+
+  list_type list{pool};
+  ASSERT_TRUE(pool.load(2, list));
+  EXPECT_EQ(make_text(600), read_text(list));
+
+  // Freed chunks are handed out again
+  std::vector<ac::persistent_chunk_pool::chunk_type> chunks;
+  while (pool.remain() > 0)
+    chunks.push_back(pool.allocate());
+  EXPECT_TRUE(pool.allocate().empty());
+  EXPECT_EQ(pool.size() - 3, chunks.size());
+}
+
+TEST(persistent_chunk_pool_test, broken_list_is_dropped)
+{
+  auto segment = std::make_unique<segment_holder>();
+  auto crashed = std::make_unique<segment_holder>();
+  {
+    ac::persistent_chunk_pool pool{segment->data, segment_size, chunk_size, lists_count};
+    list_type first{pool};
+    write_text(first, make_text(700));
+    ASSERT_TRUE(pool.store(0, first));
+    list_type second{pool};
+    write_text(second, make_text(300));
+    ASSERT_TRUE(pool.store(3, second));
+
+    // Torn write of the first record
+    auto * header = reinterpret_cast<ac::detail::persistent_pool_header *>(segment->data);
+    auto * lists = reinterpret_cast<ac::detail::persistent_list_record *>(segment->data + header->lists_offset);
+    lists[0].size += 1;
+    list_type loose{pool};
+    ASSERT_FALSE(loose.reserve().empty());
+    ::memcpy(crashed->data, segment->data, segment_size);
+  }
+
+  ac::persistent_chunk_pool pool{crashed->data, segment_size, chunk_size, lists_count};
+  EXPECT_EQ(ac::pool_attach::recovered, pool.attach_status());
+  EXPECT_FALSE(pool.stored(0));
+  EXPECT_TRUE(pool.stored(3));
+  EXPECT_EQ(2, pool.in_use());
+
+  list_type list{pool};
+  ASSERT_TRUE(pool.load(3, list));
+  EXPECT_EQ(make_text(300), read_text(list));
+}
+
+TEST(persistent_chunk_pool_test, broken_list_is_dropped_on_load)
+{
+  auto segment = std::make_unique<segment_holder>();
+  ac::persistent_chunk_pool pool{segment->data, segment_size, chunk_size, lists_count};
+  list_type list{pool};
+  write_text(list, make_text(700));
+  ASSERT_TRUE(pool.store(0, list));
+
+  auto * header = reinterpret_cast<ac::detail::persistent_pool_header *>(segment->data);
+  auto * lists = reinterpret_cast<ac::detail::persistent_list_record *>(segment->data + header->lists_offset);
+  lists[0].seq.fetch_add(1);
+
+  EXPECT_FALSE(pool.load(0, list));
+  EXPECT_FALSE(pool.stored(0));
+  EXPECT_EQ(pool.size(), pool.remain());
+}
+
+TEST(persistent_chunk_pool_test, incompatible_segment_is_formatted)
+{
+  auto segment = std::make_unique<segment_holder>();
+  {
+    ac::persistent_chunk_pool pool{segment->data, segment_size, chunk_size, lists_count};
+    list_type list{pool};
+    write_text(list, "data");
+    ASSERT_TRUE(pool.store(0, list));
+  }
+  {
+    ac::persistent_chunk_pool pool{segment->data, segment_size, chunk_size * 2, lists_count};
+    EXPECT_EQ(ac::pool_attach::formatted, pool.attach_status());
+    EXPECT_FALSE(pool.stored(0));
+  }
+
+  auto * header = reinterpret_cast<ac::detail::persistent_pool_header *>(segment->data);
+  header->version += 1;
+  ac::persistent_chunk_pool pool{segment->data, segment_size, chunk_size * 2, lists_count};
+  EXPECT_EQ(ac::pool_attach::formatted, pool.attach_status());
+  EXPECT_EQ(1, pool.generation());
+}
+
+TEST(persistent_chunk_pool_test, foreign_and_stored_chunks_are_ignored)
+{
+  auto segment = std::make_unique<segment_holder>();
+  ac::persistent_chunk_pool pool{segment->data, segment_size, chunk_size, lists_count};
+
+  list_type list{pool};
+  write_text(list, "data");
+  auto chunk = list.chunk_at(0);
+  ASSERT_TRUE(pool.store(0, list));
+  pool.deallocate(chunk);
+  EXPECT_EQ(pool.size() - 1, pool.remain());
+
+  auto other = pool.allocate();
+  pool.deallocate(other);
+  pool.deallocate(other);
+  EXPECT_EQ(pool.size() - 1, pool.remain());
+
+  std::byte foreign[chunk_size];
+  pool.deallocate(ac::persistent_chunk_pool::chunk_type{foreign, chunk_size});
+  EXPECT_EQ(pool.size() - 1, pool.remain());
+
+  pool.drop(0);
+  EXPECT_FALSE(pool.stored(0));
+  EXPECT_EQ(pool.size(), pool.remain());
+}
+
+#ifdef __linux__
+
+TEST(persistent_chunk_pool_test, restarted_process_gets_lists_back)
+{
+  const auto name = "/ac_test_" + std::to_string(::getpid()) + "_persistent";
+  ac::posix_shared_memory segment{name, segment_size};
+  ASSERT_TRUE(segment.create());
+
+  // Stores a list and crashes holding another one
+  pid_t pid = ::fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0)
+  {
+    ac::posix_shared_memory child_segment{name, 0};
+    if (child_segment.open() == false)
+      ::_exit(1);
+    child_segment.keep();
+
+    auto * pool = new ac::persistent_chunk_pool{child_segment, chunk_size, lists_count};
+    auto * stored = new list_type{*pool};
+    const auto text = make_text(900);
+    if (stored->write(reinterpret_cast<const std::byte *>(text.data()), text.size()) != text.size()
+        || pool->store(1, *stored) == false)
+      ::_exit(2);
+    auto * loose = new list_type{*pool};
+    if (loose->reserve().empty())
+      ::_exit(3);
+    ::_exit(0);
+  }
+
+  int status = 0;
+  ASSERT_EQ(pid, ::waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+
+  ac::persistent_chunk_pool pool{segment, chunk_size, lists_count};
+  EXPECT_EQ(ac::pool_attach::recovered, pool.attach_status());
+  list_type list{pool};
+  ASSERT_TRUE(pool.load(1, list));
+  EXPECT_EQ(make_text(900), read_text(list));
+  EXPECT_EQ(4, pool.in_use());
+}
+
+#endif // __linux__
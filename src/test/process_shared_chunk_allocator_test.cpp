@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include "process_shared_chunk_allocator.hpp"
+#include <cstring>
+#include <vector>
+
+#ifdef __linux__
+#include "shared_memory_allocator.hpp"
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+TEST(process_shared_chunk_allocator_test, format_and_attach)
+{
+  alignas(64) std::byte segment[8192] {};
+  ac::process_shared_chunk_allocator first{segment, sizeof(segment), 512};
+  ac::process_shared_chunk_allocator second{segment, sizeof(segment), 512};
+
+  ASSERT_LT(0, first.size());
+  EXPECT_EQ(first.size(), second.size());
+  EXPECT_EQ(first.size(), first.remain());
+
+  auto chunk = first.allocate();
+  ASSERT_EQ(512, chunk.size());
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(chunk.data()) % 64);
+  EXPECT_EQ(1, second.in_use());
+
+  second.deallocate(second.from_handle(first.to_handle(chunk)));
+  EXPECT_EQ(0, first.in_use());
+}
+
+TEST(process_shared_chunk_allocator_test, exhaustion_and_bad_frees)
+{
+  alignas(64) std::byte segment[4096] {};
+  ac::process_shared_chunk_allocator allocator{segment, sizeof(segment), 1024};
+
+  std::vector<ac::process_shared_chunk_allocator::chunk_type> chunks;
+  while (true)
+  {
+    auto chunk = allocator.allocate();
+    if (chunk.empty())
+      break;
+    EXPECT_LE(chunk.data() + chunk.size(), segment + sizeof(segment));
+    chunks.push_back(chunk);
+  }
+  EXPECT_EQ(allocator.size(), chunks.size());
+  EXPECT_EQ(0, allocator.remain());
+
+  allocator.deallocate(chunks.front().subspan(1));
+  std::byte foreign[1024] {};
+  allocator.deallocate(foreign);
+  EXPECT_EQ(0, allocator.remain());
+
+  for (auto & it : chunks)
+    allocator.deallocate(allocator.to_handle(it));
+  EXPECT_EQ(allocator.size(), allocator.remain());
+  EXPECT_TRUE(allocator.to_handle({}).empty());
+  EXPECT_TRUE(allocator.from_handle({}).empty());
+}
+
+#ifdef __linux__
+
+namespace
+{
+
+key_t test_key()
+{
+  return static_cast<key_t>(0x41430000 | (::getpid() & 0xffff));
+}
+
+} // namespace
+
+TEST(process_shared_chunk_allocator_test, different_mappings)
+{
+  ac::shared_memory_allocator owner{test_key(), 1 << 16, IPC_CREAT | 0600};
+  ASSERT_TRUE(owner.attach_or_allocate());
+  ac::shared_memory_allocator other{test_key(), 1 << 16, 0600};
+  ASSERT_TRUE(other.attach_or_allocate());
+  ASSERT_NE(owner.get_base_pointer(), other.get_base_pointer());
+
+  ac::process_shared_chunk_allocator first{owner, 1024};
+  ac::process_shared_chunk_allocator second{other, 1024};
+
+  auto chunk = first.allocate();
+  ::memcpy(chunk.data(), "hello", 6);
+
+  auto mapped = second.from_handle(first.to_handle(chunk));
+  EXPECT_NE(chunk.data(), mapped.data());
+  EXPECT_STREQ("hello", reinterpret_cast<const char *>(mapped.data()));
+
+  second.deallocate(mapped);
+  EXPECT_EQ(0, first.in_use());
+  EXPECT_TRUE(owner.remove());
+}
+
+TEST(process_shared_chunk_allocator_test, exchange_between_processes)
+{
+  ac::shared_memory_allocator segment{test_key() + 1, 1 << 16, IPC_CREAT | 0600};
+  ASSERT_TRUE(segment.attach_or_allocate());
+  ac::process_shared_chunk_allocator allocator{segment, 1024};
+
+  int fds[2];
+  ASSERT_EQ(0, ::pipe(fds));
+
+  constexpr size_t count = 16;
+  pid_t pid = ::fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0)
+  {
+    // Only handles go through the pipe, data stays in the segment
+    ::close(fds[0]);
+    ac::process_shared_chunk_allocator child{*segment.get_base_pointer(), segment.size(), 1024};
+    for (size_t i = 0; i < count; ++i)
+    {
+      auto chunk = child.allocate();
+      if (chunk.empty())
+        ::_exit(1);
+      ::memset(chunk.data(), static_cast<int>(i), chunk.size());
+      auto handle = child.to_handle(chunk);
+      if (::write(fds[1], &handle, sizeof(handle)) != sizeof(handle))
+        ::_exit(1);
+    }
+    ::_exit(0);
+  }
+
+  ::close(fds[1]);
+  size_t received = 0;
+  ac::shared_chunk_handle handle;
+  while (::read(fds[0], &handle, sizeof(handle)) == sizeof(handle))
+  {
+    auto chunk = allocator.from_handle(handle);
+    EXPECT_EQ(static_cast<std::byte>(received), chunk.front());
+    EXPECT_EQ(static_cast<std::byte>(received), chunk.back());
+    allocator.deallocate(chunk);
+    ++received;
+  }
+  ::close(fds[0]);
+
+  int status = 0;
+  ASSERT_EQ(pid, ::waitpid(pid, &status, 0));
+  EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  EXPECT_EQ(count, received);
+  EXPECT_EQ(0, allocator.in_use());
+  EXPECT_TRUE(segment.remove());
+}
+
+#endif // __linux__
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include "shared_chunk_buffer.hpp"
+#include "static_chunk_allocator.hpp"
+#include <vector>
+
+using shared_buffer = ac::shared_chunk_buffer<ac::static_chunk_allocator>;
+
+class shared_chunk_buffer_test : public ::testing::Test
+{
+protected:
+  alignas(64) std::byte _buf[256 * 8] {};
+  ac::static_chunk_allocator _alloc{_buf, sizeof(_buf), 256ul};
+  std::byte _data[1000] {};
+
+  void SetUp() override
+  {
+    for (size_t i = 0; i < sizeof(_data); ++i)
+      _data[i] = static_cast<std::byte>(i);
+  }
+};
+
+TEST_F(shared_chunk_buffer_test, write_and_read)
+{
+  shared_buffer buffer{_alloc};
+
+  EXPECT_EQ(1000, buffer.write(_data, sizeof(_data)));
+  EXPECT_EQ(1000, buffer.size());
+  // Part of every chunk is taken by the header
+  EXPECT_EQ(5, _alloc.in_use());
+
+  std::byte copy_buf[1000] {};
+  EXPECT_EQ(1000, buffer.read_copy(0, copy_buf, sizeof(copy_buf)));
+  EXPECT_EQ(0, ::memcmp(_data, copy_buf, sizeof(_data)));
+
+  buffer.clear();
+  EXPECT_EQ(0, _alloc.in_use());
+}
+
+TEST_F(shared_chunk_buffer_test, fan_out_shares_chunks)
+{
+  std::vector<shared_buffer> subscribers;
+  {
+    shared_buffer payload{_alloc};
+    ASSERT_EQ(1000, payload.write(_data, sizeof(_data)));
+
+    for (int i = 0; i < 100; ++i)
+      subscribers.push_back(payload);
+  }
+  // No chunks allocated for copies
+  EXPECT_EQ(5, _alloc.in_use());
+
+  const std::byte * first = nullptr;
+  const std::byte * last = nullptr;
+  EXPECT_NE(0, subscribers.front().read(0, first, 1));
+  EXPECT_NE(0, subscribers.back().read(0, last, 1));
+  EXPECT_EQ(first, last);
+
+  subscribers.erase(subscribers.begin() + 1, subscribers.end());
+  EXPECT_EQ(5, _alloc.in_use());
+  subscribers.clear();
+  EXPECT_EQ(0, _alloc.in_use());
+}
+
+TEST_F(shared_chunk_buffer_test, slice)
+{
+  shared_buffer buffer{_alloc};
+  ASSERT_EQ(1000, buffer.write(_data, sizeof(_data)));
+
+  auto slice = buffer.slice(200, 300);
+  EXPECT_EQ(300, slice.size());
+  EXPECT_EQ(3, slice.chunks_count());
+
+  std::byte copy_buf[300] {};
+  EXPECT_EQ(300, slice.read_copy(0, copy_buf, sizeof(copy_buf)));
+  EXPECT_EQ(0, ::memcmp(_data + 200, copy_buf, sizeof(copy_buf)));
+
+  // Chunks outside the slice are returned with the original buffer
+  buffer.clear();
+  EXPECT_EQ(3, _alloc.in_use());
+
+  EXPECT_EQ(0, buffer.slice(0, 10).size());
+  EXPECT_EQ(0, slice.slice(300, 10).size());
+}
+
+TEST_F(shared_chunk_buffer_test, write_after_copy)
+{
+  shared_buffer buffer{_alloc};
+  ASSERT_EQ(10, buffer.write(_data, 10));
+  shared_buffer copy{buffer};
+
+  // Shared chunk isn't changed, so the copy doesn't see new data
+  ASSERT_EQ(10, buffer.write(_data + 10, 10));
+  EXPECT_EQ(2, buffer.chunks_count());
+  EXPECT_EQ(10, copy.size());
+  EXPECT_EQ(2, _alloc.in_use());
+
+  std::byte copy_buf[20] {};
+  EXPECT_EQ(20, buffer.read_copy(0, copy_buf, sizeof(copy_buf)));
+  EXPECT_EQ(0, ::memcmp(_data, copy_buf, sizeof(copy_buf)));
+
+  // The only owner appends in place
+  buffer.clear();
+  EXPECT_EQ(1, _alloc.in_use());
+  ASSERT_EQ(10, copy.write(_data + 10, 10));
+  EXPECT_EQ(1, copy.chunks_count());
+  EXPECT_EQ(1, _alloc.in_use());
+
+  EXPECT_EQ(20, copy.read_copy(0, copy_buf, sizeof(copy_buf)));
+  EXPECT_EQ(0, ::memcmp(_data, copy_buf, sizeof(copy_buf)));
+}
@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+#include "shared_ring.hpp"
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include "shared_memory_allocator.hpp"
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+std::span<const std::byte> as_bytes(std::string_view str)
+{
+  return std::as_bytes(std::span{str.data(), str.size()});
+}
+
+std::string_view as_string(std::span<const std::byte> bytes)
+{
+  return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+}
+
+// Zero-filled and aligned like a new shared memory segment
+struct test_segment
+{
+  explicit test_segment(size_t size) :
+    buf{new (std::align_val_t{64}) std::byte[size]{}},
+    size{size}
+  {}
+
+  ~test_segment()
+  {
+    ::operator delete[](buf, std::align_val_t{64});
+  }
+
+  std::byte * buf;
+  size_t size;
+};
+
+} // namespace
+
+TEST(shared_ring_test, push_and_consume)
+{
+  test_segment segment{4096};
+  ac::spsc_ring producer{segment.buf, segment.size};
+  ac::spsc_ring consumer{segment.buf, segment.size};
+
+  EXPECT_EQ(2048, producer.capacity());
+  EXPECT_EQ(nullptr, consumer.front().data());
+
+  EXPECT_TRUE(producer.try_push(as_bytes("first")));
+  EXPECT_TRUE(producer.try_push(as_bytes("")));
+  EXPECT_TRUE(producer.try_push(as_bytes("third")));
+
+  std::vector<std::string> got;
+  EXPECT_EQ(3, consumer.consume([&](auto message) { got.emplace_back(as_string(message)); }));
+  EXPECT_EQ((std::vector<std::string>{"first", "", "third"}), got);
+  EXPECT_EQ(0, consumer.consume([](auto) {}));
+}
+
+TEST(shared_ring_test, prepare_commit_publish)
+{
+  test_segment segment{4096};
+  ac::spsc_ring producer{segment.buf, segment.size};
+  ac::spsc_ring consumer{segment.buf, segment.size};
+
+  for (int i = 0; i < 3; ++i)
+  {
+    auto place = producer.prepare(100);
+    ASSERT_EQ(100, place.size());
+    ::memcpy(place.data(), "abc", 3);
+    producer.commit(3);
+  }
+  // Nothing is visible before publish()
+  EXPECT_EQ(nullptr, consumer.front().data());
+
+  producer.publish();
+  EXPECT_EQ(3, consumer.consume([](auto message) { EXPECT_EQ("abc", as_string(message)); }));
+}
+
+TEST(shared_ring_test, full_and_wrap_around)
+{
+  test_segment segment{4096};
+  ac::spsc_ring producer{segment.buf, segment.size};
+  ac::spsc_ring consumer{segment.buf, segment.size};
+
+  EXPECT_FALSE(producer.try_push(std::vector<std::byte>(producer.max_message_size() + 1)));
+
+  // 300 bytes of payload take 320 of the ring, so they don't divide it
+  std::vector<std::byte> message(300);
+  size_t pushed = 0;
+  size_t popped = 0;
+  for (size_t round = 0; round < 50; ++round)
+  {
+    while (true)
+    {
+      message.front() = static_cast<std::byte>(pushed);
+      if (producer.try_push(message) == false)
+        break;
+      ++pushed;
+    }
+    EXPECT_LT(0, pushed - popped);
+
+    // Consume part of them, so the next round wraps at other place
+    auto check = [&](auto got)
+    {
+      EXPECT_EQ(300, got.size());
+      EXPECT_EQ(static_cast<std::byte>(popped), got.front());
+      ++popped;
+    };
+    (void)consumer.consume(check, 1 + round % 5);
+    if (round + 1 == 50)
+      (void)consumer.consume(check);
+  }
+  EXPECT_EQ(pushed, popped);
+}
+
+TEST(shared_ring_test, batch_is_all_or_nothing)
+{
+  test_segment segment{1024};
+  ac::spsc_ring producer{segment.buf, segment.size};
+  ac::spsc_ring consumer{segment.buf, segment.size};
+
+  std::vector<std::byte> message(200);
+  std::span<const std::byte> batch[] = {message, message, message};
+  EXPECT_TRUE(producer.try_push_batch(std::span{batch, 2}));
+  EXPECT_FALSE(producer.try_push_batch(batch));
+  EXPECT_EQ(2, consumer.consume([](auto) {}));
+  EXPECT_TRUE(producer.try_push_batch(std::span{batch, 2}));
+}
+
+TEST(shared_ring_test, multiple_producers)
+{
+  test_segment segment{1 << 16};
+  ac::mpsc_ring consumer{segment.buf, segment.size};
+
+  constexpr size_t producers_count = 4;
+  constexpr uint32_t per_producer = 20000;
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < producers_count; ++p)
+  {
+    producers.emplace_back([&, p]
+    {
+      ac::mpsc_ring producer{segment.buf, segment.size};
+      for (uint32_t i = 0; i < per_producer; ++i)
+      {
+        uint32_t message[2] = {static_cast<uint32_t>(p), i};
+        while (producer.try_push(std::as_bytes(std::span{message})) == false)
+          std::this_thread::yield();
+      }
+    });
+  }
+
+  // Messages of every producer come in order
+  std::vector<uint32_t> next(producers_count, 0);
+  size_t total = 0;
+  while (total < producers_count * per_producer)
+  {
+    total += consumer.consume([&](auto got)
+    {
+      ASSERT_EQ(8, got.size());
+      uint32_t message[2];
+      ::memcpy(message, got.data(), sizeof(message));
+      ASSERT_LT(message[0], producers_count);
+      EXPECT_EQ(next[message[0]]++, message[1]);
+    });
+  }
+  for (auto & it : producers)
+    it.join();
+  EXPECT_EQ(nullptr, consumer.front().data());
+}
+
+#ifdef __linux__
+
+TEST(shared_ring_test, blocking_between_processes)
+{
+  ac::shared_memory_allocator segment{static_cast<key_t>(0x41520000 | (::getpid() & 0xffff)),
+                                      1 << 14, IPC_CREAT | 0600};
+  ASSERT_TRUE(segment.attach_or_allocate());
+  ac::spsc_ring consumer{segment};
+
+  constexpr uint32_t count = 10000;
+  pid_t pid = ::fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0)
+  {
+    ac::spsc_ring producer{segment};
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      while (producer.try_push(std::as_bytes(std::span{&i, 1})) == false)
+      {
+        if (producer.wait_writable(sizeof(i), std::chrono::seconds{5}) == false)
+          ::_exit(1);
+      }
+    }
+    ::_exit(0);
+  }
+
+  uint32_t expected = 0;
+  while (expected < count)
+  {
+    if (consumer.wait_readable(std::chrono::seconds{5}) == false)
+      break;
+    consumer.consume([&](auto got)
+    {
+      uint32_t value;
+      ::memcpy(&value, got.data(), sizeof(value));
+      EXPECT_EQ(expected++, value);
+    });
+  }
+
+  int status = 0;
+  ASSERT_EQ(pid, ::waitpid(pid, &status, 0));
+  EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  EXPECT_EQ(count, expected);
+  EXPECT_FALSE(consumer.wait_readable(std::chrono::milliseconds{1}));
+  EXPECT_TRUE(segment.remove());
+}
+
+#endif // __linux__
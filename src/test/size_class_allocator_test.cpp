@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include "size_class_allocator.hpp"
+#include "static_chunk_allocator.hpp"
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+const ac::size_class test_classes[] = {{64, 64}, {256, 16}, {4096, 2}};
+
+} // namespace
+
+TEST(size_class_allocator_test, geometric_classes)
+{
+  auto classes = ac::geometric_size_classes(64, 64 << 10, 64 << 10);
+  ASSERT_EQ(11, classes.size());
+  EXPECT_EQ(64, classes.front().chunk_size);
+  EXPECT_EQ(1024, classes.front().chunks_count);
+  EXPECT_EQ(64 << 10, classes.back().chunk_size);
+  EXPECT_EQ(1, classes.back().chunks_count);
+  EXPECT_EQ(11 * (64 << 10), ac::size_class_allocator<>::required_size(classes));
+}
+
+TEST(size_class_allocator_test, smallest_fitting_class)
+{
+  alignas(std::max_align_t) std::byte buf[4 * 4096] {};
+  ASSERT_EQ(sizeof(buf), ac::size_class_allocator<>::required_size(test_classes));
+  ac::size_class_allocator allocator{buf, sizeof(buf), test_classes};
+
+  ASSERT_EQ(3, allocator.classes_count());
+  EXPECT_EQ(64, allocator.allocate(1).size());
+  EXPECT_EQ(64, allocator.allocate(64).size());
+  EXPECT_EQ(256, allocator.allocate(65).size());
+  EXPECT_EQ(4096, allocator.allocate(257).size());
+  EXPECT_EQ(4096, allocator.allocate(4096).size());
+  EXPECT_TRUE(allocator.allocate(4097).empty());
+
+  EXPECT_EQ(2, allocator.stats(0).in_use);
+  EXPECT_EQ(1, allocator.stats(1).in_use);
+  EXPECT_EQ(2, allocator.stats(2).in_use);
+  EXPECT_EQ(5, allocator.in_use());
+}
+
+TEST(size_class_allocator_test, class_recovered_from_pointer)
+{
+  alignas(std::max_align_t) std::byte buf[4 * 4096] {};
+  ac::size_class_allocator allocator{buf, sizeof(buf), test_classes};
+
+  std::vector<ac::size_class_allocator<>::chunk_type> chunks;
+  for (size_t len : {10, 100, 1000, 20, 200})
+    chunks.push_back(allocator.allocate(len));
+  for (auto & it : chunks)
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(it.data()) % alignof(std::max_align_t));
+
+  for (auto & it : chunks)
+    allocator.deallocate(it.data());
+  EXPECT_EQ(0, allocator.in_use());
+  for (size_t i = 0; i < allocator.classes_count(); ++i)
+    EXPECT_EQ(0, allocator.stats(i).in_use);
+
+  // Foreign pointer
+  std::byte foreign[64] {};
+  allocator.deallocate(foreign);
+  EXPECT_EQ(0, allocator.in_use());
+}
+
+TEST(size_class_allocator_test, spill_to_bigger_class)
+{
+  alignas(std::max_align_t) std::byte buf[4 * 4096] {};
+  ac::size_class_allocator allocator{buf, sizeof(buf), test_classes};
+
+  // Page tails go to the class, so there are 4096 / 256 chunks of 256 bytes
+  const size_t small_count = allocator.stats(1).chunks_count;
+  ASSERT_EQ(16, small_count);
+  for (size_t i = 0; i < small_count; ++i)
+    ASSERT_EQ(256, allocator.allocate(200).size());
+
+  auto spilled = allocator.allocate(200);
+  EXPECT_EQ(4096, spilled.size());
+  EXPECT_EQ(1, allocator.stats(1).spills);
+  EXPECT_EQ(1, allocator.stats(2).in_use);
+
+  (void)allocator.allocate(4096);
+  EXPECT_TRUE(allocator.allocate(200).empty());
+  EXPECT_EQ(1, allocator.stats(1).failures);
+
+  allocator.deallocate(spilled);
+  EXPECT_EQ(1, allocator.stats(2).in_use);
+  EXPECT_EQ(2, allocator.stats(2).high_water);
+
+  auto & stats = allocator.stats(1);
+  EXPECT_EQ(18, stats.allocations);
+  EXPECT_EQ(200 * 18, stats.requested_bytes);
+}
+
+TEST(size_class_allocator_test, page_tail_goes_to_class)
+{
+  const ac::size_class classes[] = {{48, 10}, {96, 1}};
+  alignas(std::max_align_t) std::byte buf[2 * 4096] {};
+  ac::size_class_allocator allocator{buf, sizeof(buf), classes};
+
+  EXPECT_EQ(4096 / 48, allocator.stats(0).chunks_count);
+  EXPECT_EQ(4096 / 96, allocator.stats(1).chunks_count);
+  EXPECT_EQ(48, allocator.allocate(40).size());
+  EXPECT_EQ(96, allocator.allocate(49).size());
+}
+
+TEST(size_class_allocator_test, static_chunk_allocator_pools)
+{
+  alignas(std::max_align_t) std::byte buf[4 * 4096] {};
+  ac::size_class_allocator<ac::static_chunk_allocator> allocator{buf, sizeof(buf), test_classes};
+
+  auto chunk = allocator.allocate(100);
+  EXPECT_EQ(256, chunk.size());
+  allocator.deallocate(chunk);
+  EXPECT_EQ(0, allocator.in_use());
+  EXPECT_EQ(allocator.size(), allocator.remain());
+}
@@ -128,3 +128,22 @@ TEST(static_chunk_allocator_test, deallocate_wrong_pointer)
   EXPECT_EQ(0, allocator.in_use());
   EXPECT_EQ(1, allocator.remain());
 }
+
+TEST(static_chunk_allocator_test, batch_allocs_and_deallocs)
+{
+  std::byte buf[1024] {};
+  ac::static_chunk_allocator allocator{buf, sizeof(buf), 16};
+
+  ac::static_chunk_allocator::chunk_type chunks[100];
+
+  // Only available chunks are allocated
+  size_t count = allocator.allocate_n(chunks);
+  EXPECT_EQ(64, count);
+  EXPECT_EQ(64, allocator.in_use());
+  for (size_t i = 0; i < count; ++i)
+    EXPECT_EQ(buf + i * 16, chunks[i].data());
+
+  allocator.deallocate_n(std::span{chunks, count});
+  EXPECT_EQ(0, allocator.in_use());
+  EXPECT_EQ(64, allocator.remain());
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include "stats_chunk_allocator.hpp"
+#include "static_chunk_allocator.hpp"
+#include <numeric>
+#include <thread>
+
+using stats_allocator = ac::stats_chunk_allocator<ac::static_chunk_allocator>;
+
+TEST(stats_chunk_allocator_test, counters)
+{
+  std::byte buf[1024] {};
+  stats_allocator allocator{buf, sizeof(buf), 512ul};
+
+  auto chunk1 = allocator.allocate();
+  auto chunk2 = allocator.allocate();
+  auto chunk3 = allocator.allocate();
+  EXPECT_TRUE(chunk3.empty());
+  allocator.deallocate(chunk1);
+
+  auto stats = allocator.snapshot();
+  EXPECT_EQ(2, stats.allocations);
+  EXPECT_EQ(1, stats.deallocations);
+  EXPECT_EQ(1, stats.failures);
+  EXPECT_EQ(1, stats.in_use);
+  EXPECT_EQ(2, stats.high_water);
+  EXPECT_EQ(3, std::accumulate(stats.allocate_latency.begin(),
+                               stats.allocate_latency.end(), uint64_t{0}));
+
+  allocator.deallocate(chunk2);
+  EXPECT_EQ(0, allocator.snapshot().in_use);
+  EXPECT_EQ(2, allocator.snapshot().high_water);
+  EXPECT_EQ(0, allocator.in_use());
+}
+
+TEST(stats_chunk_allocator_test, batch_counters)
+{
+  std::byte buf[1024] {};
+  stats_allocator allocator{buf, sizeof(buf), 256ul};
+
+  stats_allocator::chunk_type chunks[5];
+  size_t count = allocator.allocate_n(chunks);
+  EXPECT_EQ(4, count);
+  allocator.deallocate_n(std::span{chunks, count});
+
+  auto stats = allocator.snapshot();
+  EXPECT_EQ(4, stats.allocations);
+  EXPECT_EQ(4, stats.deallocations);
+  EXPECT_EQ(1, stats.failures);
+  EXPECT_EQ(4, stats.high_water);
+}
+
+TEST(stats_chunk_allocator_test, disabled)
+{
+  std::byte buf[1024] {};
+  ac::stats_chunk_allocator<ac::static_chunk_allocator, false> allocator{buf, sizeof(buf), 512ul};
+
+  static_assert(sizeof(allocator) == sizeof(ac::static_chunk_allocator));
+
+  auto chunk = allocator.allocate();
+  EXPECT_FALSE(chunk.empty());
+  EXPECT_EQ(1, allocator.in_use());
+  EXPECT_EQ(0, allocator.snapshot().allocations);
+}
+
+TEST(stats_chunk_allocator_test, ignored_frees)
+{
+  std::byte buf[1024] {};
+  stats_allocator allocator{buf, sizeof(buf), 512ul};
+
+  std::byte foreign[512] {};
+  allocator.deallocate({});
+  allocator.deallocate(stats_allocator::chunk_type{foreign, sizeof(foreign)});
+  stats_allocator::chunk_type empty[2];
+  allocator.deallocate_n(empty);
+
+  auto stats = allocator.snapshot();
+  EXPECT_EQ(1, stats.deallocations);
+  EXPECT_EQ(0, stats.in_use);
+
+  auto chunk = allocator.allocate();
+  stats = allocator.snapshot();
+  EXPECT_EQ(1, stats.in_use);
+  EXPECT_EQ(1, stats.high_water);
+  allocator.deallocate(chunk);
+  EXPECT_EQ(0, allocator.snapshot().in_use);
+}
+
+TEST(stats_chunk_allocator_test, high_water_over_threads)
+{
+  std::byte buf[1024] {};
+  stats_allocator allocator{buf, sizeof(buf), 256ul};
+
+  stats_allocator::chunk_type chunks[4];
+  std::thread{[&] { EXPECT_EQ(3, allocator.allocate_n(std::span{chunks, 3})); }}.join();
+  chunks[3] = allocator.allocate();
+  ac::deallocate_n(allocator, std::span<const stats_allocator::chunk_type>{chunks});
+
+  auto stats = allocator.snapshot();
+  EXPECT_EQ(0, stats.in_use);
+  EXPECT_EQ(4, stats.high_water);
+}